@@ -1,63 +1,350 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
 #include <time.h>
 #include <tgmath.h>
 #include "pixeltoposestimator.h"
 
+// Number of records converted together in the streaming mode
+#define STREAM_BATCH 4096
+// Size in bytes of the buffer of the input stream
+#define STREAM_BUFFER 65536
+// Maximum size in bytes of a formatted output record
+#define STREAM_RECORD 64
+// Step in pixels of the screen positions where the lookup table is
+// compared to the projection, and maximum distance in meters from the
+// camera of their real positions (the real positions diverge toward
+// the horizon)
+#define LUT_CHECKSTEP 3.7
+#define LUT_CHECKMAXDIST 100.0
+// Number of islands (independent populations) of the calibration, it
+// doesn't depend on the number of cores so the results are the same
+// on every host
+#define NB_ISLAND 4
+
+// Read the input file at 'path', binary or text
+// Exit if it can't be read
+static PTPEInput* LoadInput(const char* const path) {
+  PTPEInput* input = PTPEInputLoad(path);
+  if (input == NULL) {
+    FILE* inputFile = fopen(path, "r");
+    if (inputFile == NULL) {
+      fprintf(stderr, "Can't open %s\n", path);
+      exit(0);
+    }
+    input = PTPEInputLoadText(inputFile);
+    fclose(inputFile);
+    if (input == NULL) {
+      fprintf(stderr, "Invalid input file %s\n", path);
+      exit(0);
+    }
+  }
+  return input;
+}
+
+// Write the 'size' bytes of 'buffer' to the file descriptor 'fd'
+// Return true if they could be written, false else
+static bool WriteAll(const int fd, const char* buffer, size_t size) {
+  while (size > 0) {
+    ssize_t nb = write(fd, buffer, size);
+    if (nb < 0)
+      return false;
+    buffer += nb;
+    size -= nb;
+  }
+  return true;
+}
+
+// Format the value 'v' with 3 decimals at 'out'
+// Return the position after the formatted value
+static char* FormatFloat(char* out, const float v) {
+  if (!isfinite(v) || fabs(v) > 1e12) {
+    memcpy(out, "nan", 3);
+    return out + 3;
+  }
+  long long mm = llround(fabs(v) * 1000.0);
+  if (v < 0.0 && mm != 0)
+    *(out++) = '-';
+  // Write the integer part backward, then reverse it
+  long long integer = mm / 1000;
+  char* start = out;
+  do {
+    *(out++) = '0' + integer % 10;
+    integer /= 10;
+  } while (integer > 0);
+  for (char* a = start, * b = out - 1; a < b; ++a, --b) {
+    char c = *a;
+    *a = *b;
+    *b = c;
+  }
+  // Write the decimals
+  int decimal = mm % 1000;
+  out[0] = '.';
+  out[1] = '0' + decimal / 100;
+  out[2] = '0' + (decimal / 10) % 10;
+  out[3] = '0' + decimal % 10;
+  return out + 4;
+}
+
+// Convert the screen positions read from the standard input and write
+// the real positions (x, z) on the standard output, with the
+// estimator 'estimator'
+// In text mode a record is a line 'x y', and the output a line 'x z'
+// ('nan nan' for invalid lines, lines longer than STREAM_BUFFER and
+// screen positions above the horizon), in binary mode a record is a
+// pair of native floats for both the input and the output (NaN for
+// screen positions above the horizon)
+// The records are converted by batch of at most STREAM_BATCH, each
+// batch is written as soon as the records available on the input
+// have been converted, so the latency is bounded by the conversion of
+// one batch
+static void Stream(const PixelToPosEstimator* const estimator,
+  const bool isBinary) {
+  static char in[STREAM_BUFFER + 1];
+  static char out[STREAM_BATCH * STREAM_RECORD];
+  static float pxX[STREAM_BATCH];
+  static float pxY[STREAM_BATCH];
+  static float meterX[STREAM_BATCH];
+  static float meterZ[STREAM_BATCH];
+  static bool isValid[STREAM_BATCH];
+  static bool isOnGround[STREAM_BATCH];
+  size_t len = 0;
+  bool isEnd = false;
+  // Flag to memorize that the beginning of the current line has been
+  // dropped because it was longer than the buffer
+  bool isTooLong = false;
+  while (!isEnd) {
+    // Read the available bytes
+    ssize_t nbRead = 0;
+    do {
+      nbRead = read(STDIN_FILENO, in + len, STREAM_BUFFER - len);
+    } while (nbRead < 0 && errno == EINTR);
+    if (nbRead <= 0) {
+      isEnd = true;
+      // Terminate the last line
+      if (!isBinary && (len > 0 || isTooLong))
+        in[len++] = '\n';
+    } else {
+      len += nbRead;
+    }
+    // Loop on the complete records
+    size_t pos = 0;
+    bool hasRecord = true;
+    while (hasRecord) {
+      long nb = 0;
+      while (nb < STREAM_BATCH) {
+        if (isBinary) {
+          if (len - pos < 2 * sizeof(float))
+            break;
+          memcpy(pxX + nb, in + pos, sizeof(float));
+          memcpy(pxY + nb, in + pos + sizeof(float), sizeof(float));
+          isValid[nb] = true;
+          pos += 2 * sizeof(float);
+        } else {
+          char* eol = memchr(in + pos, '\n', len - pos);
+          if (eol == NULL)
+            break;
+          // Terminate the line to stop the parsing at its end
+          *eol = '\0';
+          char* end = NULL;
+          pxX[nb] = strtof(in + pos, &end);
+          isValid[nb] = (end != in + pos);
+          char* ptr = end;
+          pxY[nb] = strtof(ptr, &end);
+          isValid[nb] = isValid[nb] && end != ptr && !isTooLong;
+          isTooLong = false;
+          if (!isValid[nb]) {
+            pxX[nb] = 0.0;
+            pxY[nb] = 0.0;
+          }
+          pos = eol - in + 1;
+        }
+        ++nb;
+      }
+      hasRecord = (nb == STREAM_BATCH);
+      if (nb == 0)
+        break;
+      // Convert the batch
+      PTPEGetPxToMeterBatch(estimator, nb, pxX, pxY, meterX, meterZ);
+      // Invalidate the screen positions above the horizon, their real
+      // positions are behind the camera and can't be converted back
+      PTPEGetMeterToPxBatch(estimator, nb, meterX, meterZ, pxX, pxY,
+        isOnGround);
+      // Write the batch
+      char* ptr = out;
+      for (long iRec = 0; iRec < nb; ++iRec) {
+        isValid[iRec] = isValid[iRec] && isOnGround[iRec];
+        if (isBinary && !isValid[iRec]) {
+          meterX[iRec] = NAN;
+          meterZ[iRec] = NAN;
+        }
+        if (isBinary) {
+          memcpy(ptr, meterX + iRec, sizeof(float));
+          memcpy(ptr + sizeof(float), meterZ + iRec, sizeof(float));
+          ptr += 2 * sizeof(float);
+        } else if (isValid[iRec]) {
+          ptr = FormatFloat(ptr, meterX[iRec]);
+          *(ptr++) = ' ';
+          ptr = FormatFloat(ptr, meterZ[iRec]);
+          *(ptr++) = '\n';
+        } else {
+          memcpy(ptr, "nan nan\n", 8);
+          ptr += 8;
+        }
+      }
+      if (!WriteAll(STDOUT_FILENO, out, ptr - out))
+        return;
+    }
+    // Keep the incomplete record for the next read, a line longer than
+    // the buffer is dropped up to its end and converted to an invalid
+    // record
+    len -= pos;
+    memmove(in, in + pos, len);
+    if (len == STREAM_BUFFER) {
+      len = 0;
+      isTooLong = true;
+    }
+  }
+}
+
+// Display the average and maximum distances between the real positions
+// given by the lookup table 'lut' and by the projection of the
+// estimator 'estimator', relative to the distance from the camera,
+// over screen positions spread on the image between the nodes of the
+// table and viewing the ground within LUT_CHECKMAXDIST
+static void CheckLut(const PixelToPosEstimator* const estimator,
+  const PTPELut* const lut) {
+  double avgErr = 0.0;
+  float maxErr = 0.0;
+  long nb = 0;
+  VecFloat2D screenPos = VecFloatCreateStatic2D();
+  VecFloat2D backPos = VecFloatCreateStatic2D();
+  for (float y = 0.5; y < VecGet(&(estimator->_imgSize), 1);
+    y += LUT_CHECKSTEP) {
+    for (float x = 0.5; x < VecGet(&(estimator->_imgSize), 0);
+      x += LUT_CHECKSTEP) {
+      VecSet(&screenPos, 0, x);
+      VecSet(&screenPos, 1, y);
+      VecFloat3D realPos = PTPEGetPxToMeter(estimator, &screenPos);
+      // The real positions of the screen positions above the horizon
+      // are behind the camera
+      float dist = VecDist(&realPos, &(estimator->_cameraPos));
+      if (dist > LUT_CHECKMAXDIST ||
+        !PTPEGetMeterToPx(estimator, &realPos, &backPos))
+        continue;
+      VecFloat3D lutPos = PTPELutGetPxToMeter(lut, &screenPos);
+      float err = VecDist(&lutPos, &realPos) / dist;
+      avgErr += err;
+      if (maxErr < err)
+        maxErr = err;
+      ++nb;
+    }
+  }
+  if (nb > 0)
+    avgErr /= (double)nb;
+  printf("Lookup table error (vs screen->real) on %ld positions "
+    "within %.0fm: average %e, max %e of the distance\n", nb,
+    LUT_CHECKMAXDIST, avgErr, maxErr);
+}
 
 int main(int argc, char** argv) {
   (void)argc; (void)argv;
 
   srandom(time(NULL));
 
-  // Read the data from the file in argument
+  // Convert a text input file into a binary one
+  if (argc == 4 && strcmp(argv[1], "-convert") == 0) {
+    FILE* textFile = fopen(argv[2], "r");
+    if (textFile == NULL) {
+      fprintf(stderr, "Can't open %s\n", argv[2]);
+      exit(0);
+    }
+    PTPEInput* input = PTPEInputLoadText(textFile);
+    fclose(textFile);
+    if (input == NULL) {
+      fprintf(stderr, "Invalid input file %s\n", argv[2]);
+      exit(0);
+    }
+    if (!PTPEInputSave(input, argv[3])) {
+      fprintf(stderr, "Failed to save %s\n", argv[3]);
+      exit(0);
+    }
+    printf("Converted %ld+%ld correspondences into %s\n",
+      PTPEDatasetGetNb(input->_input), PTPEDatasetGetNb(input->_test),
+      argv[3]);
+    PTPEInputFree(&input);
+    return 0;
+  }
+
+  // Convert the screen positions from the standard input, publish
+  // them in shared memory, or create their lookup table, with the
+  // parameters calculated previously for the camera of the input file
+  if (((argc == 3 || argc == 4) && (strcmp(argv[1], "-stream") == 0 ||
+    strcmp(argv[1], "-publish") == 0)) ||
+    (argc == 3 && strcmp(argv[1], "-lut") == 0)) {
+    PTPEInput* input = LoadInput(argv[2]);
+    PixelToPosEstimator estimator = PixelToPosEstimatorCreateStatic(
+      &(input->_cameraPos), &(input->_imgSize));
+    FILE* fileParam = fopen("./param.txt", "r");
+    if (fileParam == NULL || !PTPELoadParam(&estimator, fileParam)) {
+      fprintf(stderr, "Failed to load the parameters\n");
+      exit(0);
+    }
+    fclose(fileParam);
+    if (strcmp(argv[1], "-stream") == 0) {
+      bool isBinary = (argc == 4 && strcmp(argv[3], "-binary") == 0);
+      Stream(&estimator, isBinary);
+    } else if (strcmp(argv[1], "-lut") == 0) {
+      // Reuse the lookup table cached next to the parameters if it has
+      // been created with the same parameters
+      PTPELut* lut = PTPELutLoad(&estimator, "./param.lut");
+      if (lut == NULL) {
+        printf("Calculate the lookup table...\n");
+        lut = PTPELutCreate(&estimator);
+        if (!PTPELutSave(lut, "./param.lut"))
+          fprintf(stderr, "Failed to save the lookup table\n");
+      } else {
+        printf("Reuse the lookup table...\n");
+      }
+      CheckLut(&estimator, lut);
+      PTPELutFree(&lut);
+    } else {
+      const char* name = (argc == 4 ? argv[3] : "/ptpe");
+      if (!PTPEShmPublish(&estimator, name, true))
+        fprintf(stderr, "Failed to publish %s\n", name);
+    }
+    PixelToPosEstimatorFreeStatic(&estimator);
+    PTPEInputFree(&input);
+    return 0;
+  }
+
+  // Read the data from the file in argument, binary or text
   if (argc != 2) {
     fprintf(stderr, "Usage: main <input file>\n");
+    fprintf(stderr, "       main -convert <text file> <binary file>\n");
+    fprintf(stderr, "       main -stream <input file> [-binary]\n");
+    fprintf(stderr, "       main -publish <input file> [shm name]\n");
+    fprintf(stderr, "       main -lut <input file>\n");
     exit(0);
   }
-  FILE* inputFile = fopen(argv[1], "r");
-  if (inputFile == NULL) {
-    fprintf(stderr, "Can't open %s\n", argv[0]);
-    exit(0);
-  }
-  VecFloat* posCamera = NULL;
-  VecFloat* imgSize = NULL;
-  VecLoad(&posCamera, inputFile);
-  VecLoad(&imgSize, inputFile);
-  VecFloat* POVmin = NULL;
-  VecFloat* POVmax = NULL;
-  VecLoad(&POVmin, inputFile);
-  VecLoad(&POVmax, inputFile);
-  int nbInput = 0;
-  int ret = fscanf(inputFile, "%d", &nbInput);
-  GSet inputMeter = GSetCreateStatic();
-  GSet inputPixel = GSetCreateStatic();
-  for (int iInput = 0; iInput < nbInput; ++iInput) {
-    VecFloat* posMeter = NULL;
-    VecFloat* posPixel = NULL;
-    VecLoad(&posMeter, inputFile);
-    VecLoad(&posPixel, inputFile);
-    GSetAppend(&inputMeter, posMeter);
-    GSetAppend(&inputPixel, posPixel);
-  }
-  int nbTest = 0;
-  ret = fscanf(inputFile, "%d", &nbTest);
-  (void)ret;
-  GSet testMeter = GSetCreateStatic();
-  GSet testPixel = GSetCreateStatic();
-  for (int iInput = 0; iInput < nbTest; ++iInput) {
-    VecFloat* posMeter = NULL;
-    VecFloat* posPixel = NULL;
-    VecLoad(&posMeter, inputFile);
-    VecLoad(&posPixel, inputFile);
-    GSetAppend(&testMeter, posMeter);
-    GSetAppend(&testPixel, posPixel);
-  }
-  fclose(inputFile);
+  PTPEInput* input = LoadInput(argv[1]);
+  const PTPEDataset* inputData = input->_input;
+  const PTPEDataset* testData = input->_test;
+  long nbInput = PTPEDatasetGetNb(inputData);
+  long nbTest = PTPEDatasetGetNb(testData);
 
   // Create the estimator
   PixelToPosEstimator estimator = PixelToPosEstimatorCreateStatic(
-    (VecFloat3D*)posCamera, (VecFloat2D*)imgSize);
+    &(input->_cameraPos), &(input->_imgSize));
+  // Evaluate the populations on all the available cores
+  PTPESetNbIsland(&estimator, NB_ISLAND);
+  long nbCore = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nbCore > 1)
+    PTPESetNbThread(&estimator, nbCore);
+  // Refine the result of the genetic algorithm with Levenberg-Marquardt
+  // which allows to reduce the number of epochs
+  PTPESetFlagRefine(&estimator, true);
 
   // Calculate the projection parameters
   FILE* fileParam = fopen("./param.txt", "r");
@@ -65,8 +352,19 @@ int main(int argc, char** argv) {
     printf("Calculate the projection param...\n");
     unsigned int nbEpoch = 500000;
     float prec = 0.001;
-    PTPEInit(&estimator, &inputMeter, &inputPixel, 
-      nbEpoch, prec, (VecFloat3D*)POVmin, (VecFloat3D*)POVmax);
+    // Stop as soon as the calibration has converged, as 'prec' may be
+    // unreachable with noisy measurements
+    PTPESetStagnation(&estimator, PTPEStagnationStop, 
+      PTPE_STAGNATIONWINDOW, PTPE_STAGNATIONMINIMPROVEMENT,
+      PTPE_STAGNATIONMINDIVERSITY);
+    PTPEStopReason stopReason = PTPEInitDataset(&estimator, inputData,
+      nbEpoch, prec, &(input->_POVmin), &(input->_POVmax));
+    const PTPEInitStat* stat = PTPEGetInitStat(&estimator);
+    printf("Calibration stopped after %lu epochs: %s\n", 
+      stat->_nbEpoch, PTPEStopReasonToStr(stopReason));
+    printf("Evaluations: %lu (rejected: %lu), cache hits: %lu (%.1f%%)\n", 
+      stat->_nbEval, stat->_nbRejected, stat->_nbCacheHit, 
+      100.0 * PTPEInitStatGetCacheHitRate(stat));
     fileParam = fopen("./param.txt", "w");
     if (!VecSave(estimator._param, fileParam, true)) {
       fprintf(stderr, "Failed to save the parameters\n");
@@ -74,12 +372,18 @@ int main(int argc, char** argv) {
     }
   } else {
     printf("Reuse the projection param...\n");
-    if (!VecLoad(&(estimator._param), fileParam)) {
+    if (!PTPELoadParam(&estimator, fileParam)) {
       fprintf(stderr, "Failed to load the parameters\n");
       exit(0);
     }
   }
   fclose(fileParam);
+
+  // Calculate the homography for comparison with the projection
+  bool hasHomography = 
+    PTPEInitHomographyDataset(&estimator, inputData);
+  if (!hasHomography)
+    printf("The homography can't be calculated from the input data\n");
   
   printf("\n");
   printf("Projection param: ");
@@ -89,10 +393,16 @@ int main(int argc, char** argv) {
   printf("Input data:\n\n");
   float avgErr = 0.0;
   float maxErr = 0.0;
-  for (int iInput = 0; iInput < nbInput; ++iInput) {
-    VecFloat3D* posMeter = (VecFloat3D*)GSetGet(&inputMeter, iInput);
-    VecFloat2D* posPixel = (VecFloat2D*)GSetGet(&inputPixel, iInput);
-    printf("input #%d (m): ", iInput); 
+  for (long iInput = 0; iInput < nbInput; ++iInput) {
+    VecFloat3D posMeterVec = VecFloatCreateStatic3D();
+    VecSet(&posMeterVec, 0, inputData->_meterX[iInput]);
+    VecSet(&posMeterVec, 2, inputData->_meterZ[iInput]);
+    VecFloat2D posPixelVec = VecFloatCreateStatic2D();
+    VecSet(&posPixelVec, 0, inputData->_pxX[iInput]);
+    VecSet(&posPixelVec, 1, inputData->_pxY[iInput]);
+    VecFloat3D* posMeter = &posMeterVec;
+    VecFloat2D* posPixel = &posPixelVec;
+    printf("input #%ld (m): ", iInput); 
     VecPrint(posMeter, stdout); 
     printf(" (px): "); 
     VecPrint(posPixel, stdout); 
@@ -102,7 +412,19 @@ int main(int argc, char** argv) {
     VecPrint(&estimPos, stdout);
     float error = VecDist(&estimPos, posMeter);
     printf(" (error): %fm", error); 
-    printf("\n\n");
+    printf("\n");
+    if (hasHomography) {
+      printf(" (homography): "); 
+      VecFloat3D homPos = VecFloatCreateStatic3D();
+      if (PTPEGetPxToMeterHomography(&estimator, posPixel, &homPos)) {
+        VecPrint(&homPos, stdout);
+        printf(" (error): %fm", VecDist(&homPos, posMeter)); 
+      } else {
+        printf("on the horizon");
+      }
+      printf("\n");
+    }
+    printf("\n");
     avgErr += error;
     if (maxErr < error)
       maxErr = error;
@@ -114,10 +436,16 @@ int main(int argc, char** argv) {
   printf("Test data:\n\n");
   avgErr = 0.0;
   maxErr = 0.0;
-  for (int iInput = 0; iInput < nbTest; ++iInput) {
-    VecFloat3D* posMeter = (VecFloat3D*)GSetGet(&testMeter, iInput);
-    VecFloat2D* posPixel = (VecFloat2D*)GSetGet(&testPixel, iInput);
-    printf("input #%d (m): ", iInput); 
+  for (long iInput = 0; iInput < nbTest; ++iInput) {
+    VecFloat3D posMeterVec = VecFloatCreateStatic3D();
+    VecSet(&posMeterVec, 0, testData->_meterX[iInput]);
+    VecSet(&posMeterVec, 2, testData->_meterZ[iInput]);
+    VecFloat2D posPixelVec = VecFloatCreateStatic2D();
+    VecSet(&posPixelVec, 0, testData->_pxX[iInput]);
+    VecSet(&posPixelVec, 1, testData->_pxY[iInput]);
+    VecFloat3D* posMeter = &posMeterVec;
+    VecFloat2D* posPixel = &posPixelVec;
+    printf("input #%ld (m): ", iInput); 
     VecPrint(posMeter, stdout); 
     printf(" (px): "); 
     VecPrint(posPixel, stdout); 
@@ -127,7 +455,19 @@ int main(int argc, char** argv) {
     VecPrint(&estimPos, stdout);
     float error = VecDist(&estimPos, posMeter);
     printf(" (error): %fm", error); 
-    printf("\n\n");
+    printf("\n");
+    if (hasHomography) {
+      printf(" (homography): "); 
+      VecFloat3D homPos = VecFloatCreateStatic3D();
+      if (PTPEGetPxToMeterHomography(&estimator, posPixel, &homPos)) {
+        VecPrint(&homPos, stdout);
+        printf(" (error): %fm", VecDist(&homPos, posMeter)); 
+      } else {
+        printf("on the horizon");
+      }
+      printf("\n");
+    }
+    printf("\n");
     avgErr += error;
     if (maxErr < error)
       maxErr = error;
@@ -138,22 +478,7 @@ int main(int argc, char** argv) {
   
   // Free memory
   PixelToPosEstimatorFreeStatic(&estimator);
-  while (GSetNbElem(&inputMeter) > 0) {
-    VecFloat* v = GSetPop(&inputMeter);
-    VecFree(&v);
-  }
-  while (GSetNbElem(&inputPixel) > 0) {
-    VecFloat* v = GSetPop(&inputPixel);
-    VecFree(&v);
-  }
-  while (GSetNbElem(&testMeter) > 0) {
-    VecFloat* v = GSetPop(&testMeter);
-    VecFree(&v);
-  }
-  while (GSetNbElem(&testPixel) > 0) {
-    VecFloat* v = GSetPop(&testPixel);
-    VecFree(&v);
-  }
+  PTPEInputFree(&input);
   
   // Return success code
   return 0;
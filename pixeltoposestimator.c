@@ -1,5 +1,580 @@
 #include "pixeltoposestimator.h"
 
+// ================= SIMD ==================
+
+#if defined(__AVX__)
+  #include <immintrin.h>
+  #define PTPE_SIMD_WIDTH 8
+  typedef __m256 PTPEVec;
+  #define PTPEVecSet1(X) _mm256_set1_ps(X)
+  #define PTPEVecLoad(P) _mm256_loadu_ps(P)
+  #define PTPEVecStore(P, V) _mm256_storeu_ps(P, V)
+  #define PTPEVecAdd(A, B) _mm256_add_ps(A, B)
+  #define PTPEVecSub(A, B) _mm256_sub_ps(A, B)
+  #define PTPEVecMul(A, B) _mm256_mul_ps(A, B)
+  #define PTPEVecDiv(A, B) _mm256_div_ps(A, B)
+  #define PTPEVecRound(V) _mm256_round_ps(V, \
+    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+  #define PTPEVecGt(A, B) _mm256_cmp_ps(A, B, _CMP_GT_OQ)
+  #define PTPEVecLt(A, B) _mm256_cmp_ps(A, B, _CMP_LT_OQ)
+  #define PTPEVecOr(A, B) _mm256_or_ps(A, B)
+  #define PTPEVecAnd(A, B) _mm256_and_ps(A, B)
+  #define PTPEVecMoveMask(M) _mm256_movemask_ps(M)
+  // Return B where M is set, A elsewhere
+  #define PTPEVecBlend(A, B, M) _mm256_blendv_ps(A, B, M)
+  #if defined(__FMA__)
+    #define PTPEVecMadd(A, B, C) _mm256_fmadd_ps(A, B, C)
+  #endif
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+  #define PTPE_SIMD_WIDTH 4
+  typedef __m128 PTPEVec;
+  #define PTPEVecSet1(X) _mm_set1_ps(X)
+  #define PTPEVecLoad(P) _mm_loadu_ps(P)
+  #define PTPEVecStore(P, V) _mm_storeu_ps(P, V)
+  #define PTPEVecAdd(A, B) _mm_add_ps(A, B)
+  #define PTPEVecSub(A, B) _mm_sub_ps(A, B)
+  #define PTPEVecMul(A, B) _mm_mul_ps(A, B)
+  #define PTPEVecDiv(A, B) _mm_div_ps(A, B)
+  #define PTPEVecRound(V) _mm_cvtepi32_ps(_mm_cvtps_epi32(V))
+  #define PTPEVecGt(A, B) _mm_cmpgt_ps(A, B)
+  #define PTPEVecLt(A, B) _mm_cmplt_ps(A, B)
+  #define PTPEVecOr(A, B) _mm_or_ps(A, B)
+  #define PTPEVecAnd(A, B) _mm_and_ps(A, B)
+  #define PTPEVecMoveMask(M) _mm_movemask_ps(M)
+  // Return B where M is set, A elsewhere
+  #define PTPEVecBlend(A, B, M) \
+    _mm_or_ps(_mm_andnot_ps(M, A), _mm_and_ps(M, B))
+#endif
+#if defined(PTPE_SIMD_WIDTH) && !defined(PTPEVecMadd)
+  #define PTPEVecMadd(A, B, C) PTPEVecAdd(PTPEVecMul(A, B), C)
+#endif
+
+// ================= Define ==================
+
+// Number of correspondences converted at once when evaluating
+// projection parameters
+#define PTPE_EVALBLOCKSIZE 256
+
+// Number of correspondences between two comparisons with the cutoff
+// in PTPEEvaluateParamDatasetBounded, multiple of the SIMD width
+#define PTPE_EVALBOUNDEDBLOCKSIZE 32
+
+// Maximum number of sweeps of the Jacobi eigenvalue algorithm
+#define PTPE_JACOBI_NBMAXSWEEP 100
+
+// Relative improvement of the sum of squared errors below which the
+// refinement stops
+#define PTPE_REFINE_STALL 1e-6
+
+// Margin in radians of the pitch relative to the vertical in the
+// 5 degrees of freedom model
+#define PTPE_PITCH_MARGIN 0.01
+
+// Number of Newton iterations converting real positions to screen
+// positions
+#define PTPE_METERTOPX_NBITER 6
+
+// Residual below which the Newton iterations converting real positions
+// to screen positions have converged
+#define PTPE_METERTOPX_PREC 1e-4
+
+// ================= Data structure ===================
+
+// Header of the lookup table files
+typedef struct PTPELutHeader {
+  // Magic number (PTPE_LUT_MAGIC)
+  char _magic[8];
+  // Version of the format (PTPE_LUT_VERSION)
+  uint32_t _version;
+  // Number of nodes along x and y
+  uint32_t _nbNodeX;
+  uint32_t _nbNodeY;
+  // Camera position, image dimensions and projection parameters the
+  // table was created from
+  float _cameraPos[3];
+  float _imgSize[2];
+  float _param[PTPE_NBPARAM];
+  // Padding to align the nodes
+  char _pad[56];
+} PTPELutHeader;
+
+// Header of the binary input files, its size (64 bytes) keeps the
+// following arrays aligned on PTPE_DATASET_ALIGN
+typedef struct PTPEInputHeader {
+  // Magic number (PTPE_INPUT_MAGIC)
+  char _magic[8];
+  // Version of the format (PTPE_INPUT_VERSION)
+  uint32_t _version;
+  // Number of correspondences for the calibration and for the test
+  uint32_t _nbInput;
+  uint32_t _nbTest;
+  // Camera position, image dimensions and bounds of the point of view
+  float _cameraPos[3];
+  float _imgSize[2];
+  float _POVmin[3];
+  float _POVmax[3];
+} PTPEInputHeader;
+
+// Header of the shared memory segments, its size (128 bytes) keeps the
+// grid aligned
+typedef struct PTPEShmHeader {
+  // Magic number (PTPE_SHM_MAGIC)
+  char _magic[8];
+  // Version of the format (PTPE_SHM_VERSION)
+  uint32_t _version;
+  // Sequence counter, odd while a publication is in progress
+  atomic_uint _seq;
+  // Flag set when the segment has been replaced by a new one
+  atomic_uint _isStale;
+  // Number of nodes of the grid along x and y, 0 if there is no grid
+  uint32_t _nbNodeX;
+  uint32_t _nbNodeY;
+  // Camera position, image dimensions and projection parameters
+  float _cameraPos[3];
+  float _imgSize[2];
+  float _param[PTPE_NBPARAM];
+  // Padding to align the grid
+  char _pad[48];
+} PTPEShmHeader;
+
+// Pool of threads executing a job in parallel
+typedef struct PTPEPool {
+  // Number of threads, including the calling thread
+  int _nbThread;
+  // Worker threads (_nbThread - 1)
+  pthread_t* _threads;
+  // Synchronisation
+  pthread_mutex_t _mutex;
+  pthread_cond_t _condStart;
+  pthread_cond_t _condDone;
+  // Index of the current job, incremented at each call to PTPEPoolRun
+  unsigned long _iJob;
+  // Number of worker threads which have completed the current job
+  int _nbDone;
+  // Flag to stop the worker threads
+  bool _quit;
+  // Current job, called with its argument, the index of the thread
+  // and the number of threads
+  void (*_job)(void* const arg, const int iThread, const int nbThread);
+  void* _arg;
+} PTPEPool;
+
+// Number with its derivatives relative to the projection parameters
+typedef struct PTPEDual {
+  double _v;
+  double _d[PTPE_NBPARAM];
+} PTPEDual;
+
+// Compiled projection with the derivatives of its vectors relative to
+// the projection parameters
+typedef struct PTPEDualProj {
+  PTPEDual _d[3];
+  PTPEDual _a[3];
+  PTPEDual _b[3];
+  PTPEDual _f[3];
+  double _c[3];
+  double _sx;
+  double _sy;
+  double _kx;
+  double _ox;
+  double _ky;
+  double _oy;
+} PTPEDualProj;
+
+// Inverse of a compiled projection, in the orthonormal basis
+// (r, d, e) = (A / |A|, D, B) of the decomposition of V:
+// V = (ar * s1, fd * (c1 - 1) + c2, fe * (c1 - 1) + s2)
+// (cf PTPEProj)
+typedef struct PTPEProjInv {
+  float _r[3];
+  float _d[3];
+  float _e[3];
+  float _ar;
+  float _fd;
+  float _fe;
+  // Conversion from rotation angles to screen position
+  float _ikx;
+  float _iky;
+} PTPEProjInv;
+
+// Argument of the worker threads of a PTPEPool
+typedef struct PTPEPoolWorker {
+  PTPEPool* _pool;
+  int _iThread;
+} PTPEPoolWorker;
+
+// Argument of the evaluation job of PTPEInit
+typedef struct PTPEInitEvalArg {
+  // Estimator and model of the adns
+  const PixelToPosEstimator* _estimator;
+  PTPEModel _model;
+  // GenAlgs of the islands and data set
+  GenAlg** _gas;
+  int _nbIsland;
+  const PTPEDataset* _dataset;
+  // Evaluation of each adn, island after island
+  float* _evals;
+  // Flag to memorize if the evaluation of each adn is already known
+  bool* _isKnown;
+  // Cutoff of the evaluations of each island and flag to memorize if
+  // the evaluation of each adn has been stopped by it
+  float* _cutoffs;
+  bool* _isRejected;
+} PTPEInitEvalArg;
+
+// Conditions of the end of the genetic algorithm in PTPEInit
+typedef struct PTPEInitEnd {
+  // Maximum number of epochs
+  unsigned int _nbEpoch;
+  // Average error below which the calibration stops
+  float _prec;
+  // Settings of the stagnation detection
+  const PTPEStagnation* _stagnation;
+  // Time (cf PTPEGetTime) after which the calibration stops, 0 for no
+  // limit
+  double _deadline;
+  // Flag to cancel the calibration, null if it can't be cancelled
+  const atomic_bool* _cancel;
+  // Time (cf PTPEGetTime) of the start of the calibration
+  double _start;
+} PTPEInitEnd;
+
+// Hash table of the evaluations of adns, with open addressing
+typedef struct PTPEEvalCache {
+  // Length of the adns
+  int _lenAdn;
+  // Number of slots, power of 2
+  long _nbSlot;
+  // Adns, evaluations and flags of the slots
+  float* _adns;
+  float* _evals;
+  bool* _isUsed;
+} PTPEEvalCache;
+
+// Calibration running on a background thread
+struct PTPEBackground {
+  // Thread running the calibration
+  pthread_t _thread;
+  // Estimator published by the calibration
+  PixelToPosEstimator* _target;
+  // Private copy of the estimator calibrated by the thread
+  PixelToPosEstimator _estimator;
+  // Private copy of the data set and arguments of the calibration
+  PTPEDataset* _dataset;
+  unsigned int _nbEpoch;
+  float _prec;
+  VecFloat3D _POVmin;
+  VecFloat3D _POVmax;
+  // Flags to request the cancellation and to memorize the end of the
+  // calibration
+  atomic_bool _cancel;
+  atomic_bool _isDone;
+  // Reason of the end of the calibration
+  PTPEStopReason _stopReason;
+  // Compiled projection published at the end of the calibration, null
+  // if it has been cancelled
+  PTPEProj* _snapshot;
+  // Compiled projection replaced by the published one
+  PTPEProj* _replaced;
+};
+
+// ================ Functions declaration ====================
+
+// Create a pool of 'nbThread' threads (including the calling thread)
+static PTPEPool* PTPEPoolCreate(const int nbThread);
+
+// Free the pool of threads 'that'
+static void PTPEPoolFree(PTPEPool** that);
+
+// Execute the 'job' with its argument 'arg' on all the threads of the
+// pool 'that' and wait for its completion
+static void PTPEPoolRun(PTPEPool* const that, 
+  void (*job)(void* const arg, const int iThread, const int nbThread),
+  void* const arg);
+
+// Main function of the worker threads of a PTPEPool
+static void* PTPEPoolWorkerMain(void* arg);
+
+// Reallocate the arrays of the PTPEDataset 'that' to contain
+// 'capacity' correspondences, the four arrays are allocated in one
+// aligned block
+static void PTPEDatasetReserve(PTPEDataset* const that,
+  const long capacity);
+
+// Create a new PTPEDataset of 'nb' correspondences using the arrays
+// stored one after the other every 'stride' floats from 'arrays'
+// without copying them
+static PTPEDataset* PTPEDatasetCreateView(const long nb,
+  float* const arrays, const long stride);
+
+// Calculate the real positions (x, z) of the 'nbNodeX' x 'nbNodeY'
+// nodes of the lookup table of the estimator 'that' into 'meter', row
+// by row
+static void PTPELutFill(const PixelToPosEstimator* const that,
+  const long nbNodeX, const long nbNodeY, float* const meter);
+
+// Return Ry('dist') and its derivative in 'dRy' for the PTPEEllipse
+// 'that' (cf PTPEEllipse)
+static double PTPEEllipseGetRy(const PTPEEllipse* const that,
+  const double dist, double* const dRy);
+
+// Return the number of floats occupied by an array of 'nb' floats in
+// a binary input file, padded to keep the next array aligned
+static long PTPEInputGetStride(const long nb);
+
+// Write the arrays of the PTPEDataset 'that' in the binary input
+// file 'stream'
+// Return true if the arrays could be written, false else
+static bool PTPEInputSaveDataset(const PTPEDataset* const that,
+  FILE* const stream);
+
+// Read 'nb' correspondences from the text file 'stream' into the
+// PTPEDataset 'that'
+// Return true if the correspondences could be read, false else
+static bool PTPEInputLoadTextDataset(PTPEDataset* const that,
+  const int nb, FILE* const stream);
+
+// Write the 'dim' values 'val' as a vector into the text file 'stream'
+// (cf VecLoad)
+// Return true if the vector could be written, false else
+static bool PTPEInputSaveTextVec(FILE* const stream, const int dim,
+  const float* const val);
+
+// Write the number of correspondences and the correspondences of the
+// PTPEDataset 'that' into the text file 'stream'
+// Return true if they could be written, false else
+static bool PTPEInputSaveTextDataset(const PTPEDataset* const that,
+  FILE* const stream);
+
+// Operations on PTPEDual
+static PTPEDual PTPEDualAdd(const PTPEDual a, const PTPEDual b);
+static PTPEDual PTPEDualSub(const PTPEDual a, const PTPEDual b);
+static PTPEDual PTPEDualMul(const PTPEDual a, const PTPEDual b);
+static PTPEDual PTPEDualDiv(const PTPEDual a, const PTPEDual b);
+static PTPEDual PTPEDualSqrt(const PTPEDual a);
+
+// Normalise the vector 'v'
+static void PTPEDualNormalise(PTPEDual v[3]);
+
+// Calculate the cross product 'res' = 'a' x 'b'
+static void PTPEDualCrossProd(const PTPEDual a[3], const PTPEDual b[3],
+  PTPEDual res[3]);
+
+// Build the compiled projection with derivatives 'proj' from the
+// camera position 'cameraPos', the image dimensions 'imgSize' and the
+// projection parameters 'param' (cf PTPEProjCompile)
+static void PTPEDualProjCompile(PTPEDualProj* const proj,
+  const VecFloat3D* const cameraPos, const VecFloat2D* const imgSize,
+  const double* const param);
+
+// Calculate the real position ('res[0]', 0.0, 'res[1]') of the screen
+// position ('x', 'y') and its jacobian 'jac' relative to the
+// projection parameters with the compiled projection 'proj'
+static void PTPEDualProjGetPxToMeter(const PTPEDualProj* const proj,
+  const float x, const float y, double res[2],
+  double jac[2][PTPE_NBPARAM]);
+
+// Calculate the sum of squared errors of the data set 'dataset' for
+// the projection parameters 'param', and if 'jtj' and 'jtr' are not
+// null, the matrix J^t.J and vector J^t.r of the residuals r
+static double PTPEGetSSE(const PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const double* const param,
+  double jtj[PTPE_NBPARAM][PTPE_NBPARAM], double jtr[PTPE_NBPARAM]);
+
+// Solve the linear system 'mat'.'x' = 'vec' of dimension PTPE_NBPARAM
+// with Gaussian elimination, 'mat' and 'vec' are modified
+// Return false if the system is singular, true else
+static bool PTPESolve8(double mat[PTPE_NBPARAM][PTPE_NBPARAM],
+  double vec[PTPE_NBPARAM], double x[PTPE_NBPARAM]);
+
+// Calculate the bounds 'bounds' of the yaw and pitch of the directions
+// from the camera of the estimator 'that' to the bounding box
+// 'POVmin'-'POVmax'
+static void PTPEGet5DOFBounds(const PixelToPosEstimator* const that,
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax,
+  float bounds[2][2]);
+
+// Calculate the similarity normalizing the 'nb' points ('x', 'y') 
+// (centroid at origin, average distance to origin equal to sqrt(2))
+// as 'scale' and 'offset' such as x' = scale * x + offset[0] and
+// y' = scale * y + offset[1]
+static void PTPEGetNormalization(const long nb, const float* const x,
+  const float* const y, double* const scale, double* const offset);
+
+// Calculate the eigen values 'val' and eigen vectors 'vec' (in
+// columns) of the symmetric 9x9 matrix 'mat' with the Jacobi
+// eigenvalue algorithm, 'mat' is modified
+static void PTPEGetEigen9(double mat[9][9], double val[9],
+  double vec[9][9]);
+
+// Evaluation job of PTPEInit, the thread 'iThread' evaluates the adns
+// 'iThread', 'iThread' + 'nbThread', ...
+static void PTPEInitEvalJob(void* const arg, const int iThread,
+  const int nbThread);
+
+// Return the evaluation above which an adn can't be one of the elites
+// of the island 'iIsland' of the argument 'evalArg', from the
+// evaluations already known
+static float PTPEInitGetCutoff(const PTPEInitEvalArg* const evalArg,
+  const int iIsland);
+
+// Get the bounds 'bounds' of the adns for the calibration of the
+// estimator 'that' with the POV in the bounding box 'POVmin'-'POVmax'
+// Return the length of the adns
+static int PTPEInitGetBounds(const PixelToPosEstimator* const that, 
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax,
+  float bounds[PTPE_NBPARAM][2]);
+
+// Create a GenAlg for the calibration with adns of length 'lenAdn'
+// and bounds 'bounds'
+static GenAlg* PTPEInitCreateGenAlg(const int lenAdn,
+  const float bounds[PTPE_NBPARAM][2]);
+
+// Return the diversity of the population of the GenAlg 'ga' with
+// bounds 'bounds', the average over the values of the adns of their
+// standard deviation relative to the range of their bounds
+static float PTPEInitGetDiversity(const GenAlg* const ga, 
+  const float bounds[PTPE_NBPARAM][2]);
+
+// Init the GenAlgs 'gas' of the 'nbIsland' islands with the random
+// number generator states 'rndStates' (null to use the current state)
+static void PTPEInitIslands(GenAlg** const gas, const int nbIsland,
+  unsigned int* const rndStates);
+
+// Seed the random number generators (rand and random) used by the
+// GenAlg of the island 'iIsland' from its own state in 'rndStates'
+// (cf rand_r), so each island draws a reproducible sequence whatever
+// the implementation of rand and random
+static void PTPESeedIsland(unsigned int* const rndStates,
+  const int iIsland);
+
+// Reset the statistics 'that'
+static void PTPEInitStatReset(PTPEInitStat* const that);
+
+// Main function of the thread of the background calibration 'arg'
+// (PTPEBackground*)
+static void* PTPEBackgroundMain(void* arg);
+
+// Run the genetic algorithm calibrating the estimator 'that' on the
+// data set 'dataset' with the adns of the model 'model' in the bounds
+// 'bounds', until one of the conditions 'end' is met
+// If 'seed' is not null it is inserted in the initial populations
+// 'bestAdn' is set to the best adn found, the statistics of 'that'
+// are updated
+// Return the reason of the end of the calibration
+static PTPEStopReason PTPEInitRun(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const PTPEModel model,
+  const float bounds[PTPE_NBPARAM][2], const PTPEInitEnd* const end,
+  const VecFloat* const seed, VecFloat* const bestAdn);
+
+// Copy the best adn of each island of the argument 'evalArg' over the
+// worst adn of the next island, and memorize its evaluation in the
+// caches 'caches' of the islands
+static void PTPEInitMigrate(PTPEInitEvalArg* const evalArg,
+  PTPEEvalCache** const caches);
+
+// Comparison function for qsort of floats in ascending order
+static int PTPECmpFloat(const void* a, const void* b);
+
+// Create a cache of evaluations for at least 'nbAdn' adns of length
+// 'lenAdn'
+static PTPEEvalCache* PTPEEvalCacheCreate(const int lenAdn, 
+  const long nbAdn);
+
+// Free the cache of evaluations 'that'
+static void PTPEEvalCacheFree(PTPEEvalCache** that);
+
+// Empty the cache of evaluations 'that'
+static void PTPEEvalCacheClear(PTPEEvalCache* const that);
+
+// Search the evaluation of the adn 'adn' in the cache 'that'
+// Return true and set 'eval' if found, false else
+static bool PTPEEvalCacheGet(const PTPEEvalCache* const that,
+  const VecFloat* const adn, float* const eval);
+
+// Add the evaluation 'eval' of the adn 'adn' in the cache 'that'
+static void PTPEEvalCachePut(PTPEEvalCache* const that,
+  const VecFloat* const adn, const float eval);
+
+// Return the slot of the adn 'adn' in the cache 'that', or the first
+// unused slot where it should be added
+static long PTPEEvalCacheGetSlot(const PTPEEvalCache* const that,
+  const VecFloat* const adn);
+
+// Build the compiled projection 'proj' from the camera position
+// 'cameraPos', the image dimensions 'imgSize' and the projection
+// parameters 'param'
+static void PTPEProjCompile(PTPEProj* const proj,
+  const VecFloat3D* const cameraPos, const VecFloat2D* const imgSize,
+  const VecFloat* const param);
+
+// Return the compiled projection of the estimator 'that' if it is up
+// to date, else build it into 'buffer' and return 'buffer'
+// The query is registered in the parity 'epoch' of the epoch and the
+// returned projection stays valid until PTPEReleaseProj is called
+static const PTPEProj* PTPEGetProj(const PixelToPosEstimator* const that,
+  PTPEProj* const buffer, unsigned int* const epoch);
+
+// End the query of the estimator 'that' registered in the parity
+// 'epoch' of the epoch by PTPEGetProj
+static void PTPEReleaseProj(const PixelToPosEstimator* const that,
+  const unsigned int epoch);
+
+// Wait for the end of the queries of the estimator 'that' which may
+// be using the projection it published before the call, or its own
+// one if none was published
+static void PTPESynchronize(PixelToPosEstimator* const that);
+
+// Same as PTPERefine but the iterations also stop at the time
+// 'deadline' (cf PTPEGetTime), 0 for no deadline
+static float PTPERefineDeadline(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const int nbMaxIter,
+  const double deadline);
+
+// Convert the rotation angles ('thetaX', 'thetaY') to the real
+// position ('x', 0.0, 'z') with the compiled projection 'proj'
+static void PTPEProjGetAngleToMeter(const PTPEProj* const proj,
+  const float thetaX, const float thetaY, float* const x,
+  float* const z);
+
+// Convert the screen positions of index 'from' to 'nb' - 1 with the
+// scalar code
+static void PTPEGetPxToMeterBatchScalar(const PTPEProj* const proj,
+  const long from, const long nb, const float* const pxX,
+  const float* const pxY, float* const meterX, float* const meterZ);
+
+#if defined(PTPE_SIMD_WIDTH)
+// Calculate the sine and cosine of the angles 'x'
+static void PTPEVecSinCos(const PTPEVec x, PTPEVec* const s,
+  PTPEVec* const c);
+
+// Approximate the arctangent of 'x'
+static PTPEVec PTPEVecAtanApprox(const PTPEVec x);
+#endif
+
+// Build the inverse 'inv' of the compiled projection 'proj'
+static void PTPEProjInvCompile(PTPEProjInv* const inv,
+  const PTPEProj* const proj);
+
+// Convert the real position ('x', 0.0, 'z') to the screen position
+// ('pxX', 'pxY') with the compiled projection 'proj' and its inverse
+// 'inv'
+// Return false if the position is behind the camera or beyond the
+// horizon, true else
+static bool PTPEProjGetMeterToPx(const PTPEProj* const proj,
+  const PTPEProjInv* const inv, const float x, const float z,
+  float* const pxX, float* const pxY);
+
+// Convert the real positions of index 'from' to 'nb' - 1 with the
+// scalar code
+static void PTPEGetMeterToPxBatchScalar(const PTPEProj* const proj,
+  const PTPEProjInv* const inv, const long from, const long nb,
+  const float* const meterX, const float* const meterZ,
+  float* const pxX, float* const pxY, bool* const isValid);
+
+// ================ Functions implementation ====================
+
 // Create a new PixelToPosEstimator
 PixelToPosEstimator PixelToPosEstimatorCreateStatic(
   VecFloat3D* posCamera, const VecFloat2D* const imgSize) {
@@ -21,6 +596,26 @@ PixelToPosEstimator PixelToPosEstimatorCreateStatic(
   estimator._cameraPos = *posCamera;
   estimator._imgSize = *imgSize;
   estimator._param = VecFloatCreate(PTPE_NBPARAM);
+  estimator._proj._isValid = false;
+  estimator._nbThread = 1;
+  estimator._flagRefine = false;
+  estimator._model = PTPEModelPOV;
+  estimator._nbIsland = 1;
+  estimator._migrationPeriod = PTPE_MIGRATIONPERIOD;
+  estimator._stagnation._policy = PTPEStagnationIgnore;
+  estimator._stagnation._window = PTPE_STAGNATIONWINDOW;
+  estimator._stagnation._minImprovement = PTPE_STAGNATIONMINIMPROVEMENT;
+  estimator._stagnation._minDiversity = PTPE_STAGNATIONMINDIVERSITY;
+  PTPEInitStatReset(&(estimator._stat));
+  for (int i = 9; i--;)
+    estimator._homography[i] = (i % 4 == 0 ? 1.0 : 0.0);
+  atomic_init(&(estimator._live), NULL);
+  atomic_init(&(estimator._epoch), 0);
+  atomic_init(estimator._nbQuery, 0);
+  atomic_init(estimator._nbQuery + 1, 0);
+  estimator._background = NULL;
+  estimator._progress = NULL;
+  estimator._progressData = NULL;
   // Return the new estimator
   return estimator;
 }
@@ -29,6 +624,11 @@ PixelToPosEstimator PixelToPosEstimatorCreateStatic(
 void PixelToPosEstimatorFreeStatic(PixelToPosEstimator* const that) {
   if (that == NULL)
     return;
+  if (that->_background != NULL) {
+    PTPEBackgroundCancel(that);
+    PTPEBackgroundJoin(that);
+  }
+  free((PTPEProj*)atomic_load(&(that->_live)));
   VecFree(&(that->_param));
 }
 
@@ -50,41 +650,14 @@ VecFloat3D PTPEGetPolarToMeter(
 #endif
   // Declare a variable to memorize the result
   VecFloat3D res = VecFloatCreateStatic3D();
+  // Get the compiled projection
+  PTPEProj buffer;
+  unsigned int epoch = 0;
+  const PTPEProj* proj = PTPEGetProj(that, &buffer, &epoch);
   // Calculate the real coordinates
-
-  // POV
-  VecFloat3D P = VecFloatCreateStatic3D();
-  VecSet(&P, 0, PTPE_Px(that));
-  VecSet(&P, 1, PTPE_Py(that));
-  VecSet(&P, 2, PTPE_Pz(that));
-  // Normalized vector Camera->POV
-  VecFloat3D CP = VecGetOp(&P, 1.0, &(that->_cameraPos), -1.0);
-  VecNormalise(&CP);
-  // Normalized up vector
-  VecFloat3D Up = VecFloatCreateStatic3D();
-  VecSet(&Up, 0, PTPE_Upx(that));
-  VecSet(&Up, 1, PTPE_Upy(that));
-  VecSet(&Up, 2, PTPE_Upz(that));
-  VecNormalise(&Up);
-  // Normalized right vector
-  VecFloat3D Right = VecCrossProd(&CP, &Up);
-  VecNormalise(&Right);
-  // Rotation according to up and right
-  VecFloat3D Rx = CP;
-  VecRotAxis(&Rx, &Up, PTPE_Sx(that) * VecGet(polarPos, 0));
-  Rx = VecGetOp(&Rx, 1.0, &CP, -1.0);
-  VecFloat3D Ry = CP;
-  VecRotAxis(&Ry, &Right, PTPE_Sy(that) * VecGet(polarPos, 1));
-  Ry = VecGetOp(&Ry, 1.0, &CP, -1.0);
-  // 3d vector from camera corresponding to the polar pos pixel
-  VecFloat3D V = VecGetOp(&CP, 1.0, &Rx, 1.0);
-  V = VecGetOp(&V, 1.0, &Ry, 1.0);
-  VecNormalise(&V);
-  // Projection to ground plane
-  float a = VecGet(&(that->_cameraPos), 1) / VecGet(&V, 1);
-  VecSet(&res, 0, VecGet(&(that->_cameraPos), 0) - a * VecGet(&V, 0));
-  VecSet(&res, 1, 0.0);
-  VecSet(&res, 2, VecGet(&(that->_cameraPos), 2) - a * VecGet(&V, 2));
+  PTPEProjGetAngleToMeter(proj, proj->_sx * VecGet(polarPos, 0),
+    proj->_sy * VecGet(polarPos, 1), res._val, res._val + 2);
+  PTPEReleaseProj(that, epoch);
 
   // Return the result
   return res;
@@ -122,7 +695,7 @@ VecFloat2D PTPEGetPxToPolar(
 // Search for the parameters Px, Py, Pz in the bounding box defined
 // by POVmin-POVmax
 // the random generator must be initialized before calling this function
-void PTPEInit(PixelToPosEstimator* const that,
+PTPEStopReason PTPEInit(PixelToPosEstimator* const that,
   const GSet* const posMeter, const GSet* const posPixel, 
   const unsigned int nbEpoch, const float prec,
   const VecFloat3D* const POVmin, const VecFloat3D* const POVmax) {
@@ -167,107 +740,4481 @@ void PTPEInit(PixelToPosEstimator* const that,
     PBErrCatch(PixelToPosEstimatorErr);
   }
 #endif
-  // Create the GenAlg
-  int lengthAdnF = PTPE_NBPARAM;
-  int lengthAdnI = 0;
-  GenAlg* ga = GenAlgCreate(GENALG_NBENTITIES, GENALG_NBELITES, 
-    lengthAdnF, lengthAdnI);
-  // Set the boundaries for the parameters
-  VecFloat2D boundsF = VecFloatCreateStatic2D();
-  VecSet(&boundsF, 0, VecGet(POVmin, 0)); 
-  VecSet(&boundsF, 1, VecGet(POVmax, 0));
-  GASetBoundsAdnFloat(ga, 0, &boundsF); // Px
-  VecSet(&boundsF, 0, VecGet(POVmin, 1)); 
-  VecSet(&boundsF, 1, VecGet(POVmax, 1));
-  GASetBoundsAdnFloat(ga, 1, &boundsF); // Py
-  VecSet(&boundsF, 0, VecGet(POVmin, 2)); 
-  VecSet(&boundsF, 1, VecGet(POVmax, 2));
-  GASetBoundsAdnFloat(ga, 2, &boundsF); // Pz
-  VecSet(&boundsF, 0, -PBMATH_HALFPI); 
-  VecSet(&boundsF, 1, PBMATH_HALFPI);
-  GASetBoundsAdnFloat(ga, 3, &boundsF); // Sx
-  GASetBoundsAdnFloat(ga, 4, &boundsF); // Sy
-  VecSet(&boundsF, 0, -1.0); VecSet(&boundsF, 1, 1.0);
-  GASetBoundsAdnFloat(ga, 5, &boundsF); // Upx
-  VecSet(&boundsF, 0, 0.0); VecSet(&boundsF, 1, 1.0);
-  GASetBoundsAdnFloat(ga, 6, &boundsF); // Upy
-  VecSet(&boundsF, 0, -1.0); VecSet(&boundsF, 1, 1.0);
-  GASetBoundsAdnFloat(ga, 7, &boundsF); // Upz
-  // Init the GenAlg
-  GAInit(ga);
-  // Variable to memorize the current best adn value
-  float best = 10000.0;
-  // Loop on epochs
-  do {
-    //printf("epoch %ld avg err %fm     \r", 
-    //  GAGetCurEpoch(ga), best / (float)GSetNbElem(posMeter));
-    //fflush(stdout);
-    // Variable to memorize the evaluation of one base
-    float ev = 0.0;
-    // Loop on adns
-    for (int iEnt = 0; iEnt < GAGetNbAdns(ga); ++iEnt) {
-      // Copy the adn into the estimator's parameters
-      VecCopy(that->_param, GAAdnAdnF(GAAdn(ga, iEnt)));
-      // Reset the evaluation variable
-      ev = 0.0;
-      // Loop on both sets
-      GSetIterForward iterMeter = GSetIterForwardCreateStatic(posMeter);
-      GSetIterForward iterPixel = GSetIterForwardCreateStatic(posPixel);
-      do {
-        // Get the screen position
-        VecFloat2D* pPixel = GSetIterGet(&iterPixel);
-        // Convert to polar position
-        VecFloat2D polarPos = PTPEGetPxToPolar(that, pPixel);
-        // Convert to real position
-        VecFloat3D pEstim = PTPEGetPolarToMeter(that, &polarPos);
-        // Get the correct real position
-        VecFloat3D* pMeter = GSetIterGet(&iterMeter);
-        // Calculate the error
-        ev += VecDist(pMeter, &pEstim);
-      } while (GSetIterStep(&iterMeter) && GSetIterStep(&iterPixel));
-      // Calculate the average error
-      ev /=  (float)GSetNbElem(posMeter);
-      // Update the value of this adn
-      GASetAdnValue(ga, GAAdn(ga, iEnt), -1.0 * ev);
-      // Update the best value if necessary
-      if (ev < best - PBMATH_EPSILON) {
-        best = ev;
-        printf("%lu %f ", GAGetCurEpoch(ga), best);
-        VecFloatPrint(that->_param, stdout, 6);
-        printf("        \n"); fflush(stdout);
-      }
+  // Pack the correspondences
+  PTPEDataset* dataset = PTPEDatasetCreateFromGSet(posMeter, posPixel);
+  // Calculate the projection parameters
+  PTPEStopReason stopReason = 
+    PTPEInitDataset(that, dataset, nbEpoch, prec, POVmin, POVmax);
+  // Free memory
+  PTPEDatasetFree(&dataset);
+  // Return the reason of the end of the calibration
+  return stopReason;
+}
+
+// Same as PTPEInit with the correspondences given as a PTPEDataset
+PTPEStopReason PTPEInitDataset(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset,
+  const unsigned int nbEpoch, const float prec,
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax) {
+  // Calibrate without time budget nor cancellation
+  return PTPEInitDatasetBudget(that, dataset, nbEpoch, prec, 
+    POVmin, POVmax, 0.0, NULL);
+}
+
+// Same as PTPEInitDataset but the calibration also stops when
+// 'timeBudget' seconds have elapsed (if 'timeBudget' > 0) or when
+// 'cancel' is set to true (if 'cancel' is not null), both checked
+// between two epochs
+// The projection parameters are always set to the best ones found so
+// far, and their average error is available in the statistics (cf
+// PTPEGetInitStat)
+// The refinement (cf PTPESetFlagRefine) is skipped if the calibration
+// is cancelled or has used its time budget, else it stops at the end
+// of the time budget, so the calibration returns within the budget
+// plus one epoch
+PTPEStopReason PTPEInitDatasetBudget(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset,
+  const unsigned int nbEpoch, const float prec,
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax,
+  const double timeBudget, const atomic_bool* const cancel) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'dataset' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset->_nb <= 2) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'dataset' doesn't have enough elements (%ld>2)", dataset->_nb);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (POVmin == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'POVmin' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (POVmax == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'POVmax' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Get the bounds of the adns
+  float bounds[PTPE_NBPARAM][2];
+  int lengthAdnF = PTPEInitGetBounds(that, POVmin, POVmax, bounds);
+  // Conditions of the end of the calibration
+  double start = PTPEGetTime();
+  PTPEInitEnd end;
+  end._nbEpoch = nbEpoch;
+  end._prec = prec;
+  end._stagnation = &(that->_stagnation);
+  end._deadline = (timeBudget > 0.0 ? start + timeBudget : 0.0);
+  end._cancel = cancel;
+  end._start = start;
+  // Run the genetic algorithm
+  PTPEInitStatReset(&(that->_stat));
+  VecFloat* bestAdnF = VecFloatCreate(lengthAdnF);
+  PTPEStopReason stopReason = PTPEInitRun(that, dataset, that->_model,
+    bounds, &end, NULL, bestAdnF);
+  // Copy the best adn into the estimator's parameters
+  if (that->_model == PTPEModel5DOF) {
+    VecFloat* param = VecFloatCreate(PTPE_NBPARAM);
+    PTPEParam5DOFToParam(that, bestAdnF, param);
+    PTPESetParam(that, param);
+    VecFree(&param);
+  } else {
+    PTPESetParam(that, bestAdnF);
+  }
+  VecFree(&bestAdnF);
+  // Refine the best adn if requested, within the remaining time, unless
+  // the calibration has been cancelled or has used its time budget
+  if (that->_flagRefine && stopReason != PTPEStopReasonCancel &&
+    stopReason != PTPEStopReasonTimeBudget)
+    that->_stat._bestErr = PTPERefineDeadline(that, dataset,
+      PTPE_REFINE_NBMAXITER, end._deadline);
+  // Memorize the duration of the calibration
+  that->_stat._elapsed = PTPEGetTime() - start;
+  // Return the reason of the end of the calibration
+  return stopReason;
+}
+
+// Recalibrate the estimator 'that' from its current projection
+// parameters with the correspondences of the data set 'dataset'
+// The genetic algorithm searches the 5 degrees of freedom (cf
+// PTPEParam5DOFToParam) around the current parameters, within
+// 'radius' (in radians) for the yaw, pitch and roll and within
+// 'radiusScale' (relative to their value) for Sx and Sy, then again
+// around the best parameters found with half the radii, and so on for
+// PTPE_RECALIBNBSTAGE stages
+// Each stage lasts at most 'nbEpoch' / PTPE_RECALIBNBSTAGE epochs and
+// stops earlier if it stagnates (cf PTPESetStagnation) or if the
+// average error gets below 'prec'
+// The projection parameters are updated only if the average error
+// decreases, and refined if the refine flag is set
+// Return the reason of the end of the recalibration
+PTPEStopReason PTPERecalibrate(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const unsigned int nbEpoch, 
+  const float prec, const float radius, const float radiusScale) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'dataset' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset->_nb <= 2) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'dataset' doesn't have enough elements (%ld>2)", dataset->_nb);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (radius <= 0.0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'radius' is invalid (%f>0)", radius);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (radiusScale <= 0.0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'radiusScale' is invalid (%f>0)", radiusScale);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Each stage stops as soon as it stagnates
+  double start = PTPEGetTime();
+  PTPEStagnation stagnation = that->_stagnation;
+  stagnation._policy = PTPEStagnationStop;
+  PTPEInitEnd end;
+  end._nbEpoch = nbEpoch / PTPE_RECALIBNBSTAGE;
+  if (end._nbEpoch == 0)
+    end._nbEpoch = 1;
+  end._prec = prec;
+  end._stagnation = &stagnation;
+  end._deadline = 0.0;
+  end._cancel = NULL;
+  end._start = start;
+  // Current parameters as the center of the first stage
+  VecFloat* center = VecFloatCreate(PTPE_NBPARAM5DOF);
+  PTPEParamToParam5DOF(that, that->_param, center);
+  VecFloat* bestAdnF = VecFloatCreate(PTPE_NBPARAM5DOF);
+  // Loop on stages
+  PTPEInitStatReset(&(that->_stat));
+  PTPEStopReason stopReason = PTPEStopReasonNbEpoch;
+  float radiusStage = radius;
+  float radiusScaleStage = radiusScale;
+  for (int iStage = 0; iStage < PTPE_RECALIBNBSTAGE &&
+    stopReason != PTPEStopReasonPrec; ++iStage) {
+    // Bounds around the center, the yaw, pitch and roll are angles,
+    // Sx and Sy scale factors
+    float bounds[PTPE_NBPARAM][2];
+    for (int i = 0; i < PTPE_NBPARAM5DOF; ++i) {
+      float r = (i < 3 ? radiusStage :
+        radiusScaleStage * fabs(VecGet(center, i)));
+      bounds[i][0] = VecGet(center, i) - r;
+      bounds[i][1] = VecGet(center, i) + r;
     }
-    // Step the GenAlg
-    GAStep(ga);
-  } while (GAGetCurEpoch(ga) < nbEpoch && best > prec);
-  // Copy the final best adn into the estimator's parameters
-  VecCopy(that->_param, GAAdnAdnF(GABestAdn(ga)));
+    if (bounds[1][0] < -1.0 * PBMATH_HALFPI + PTPE_PITCH_MARGIN)
+      bounds[1][0] = -1.0 * PBMATH_HALFPI + PTPE_PITCH_MARGIN;
+    if (bounds[1][1] > PBMATH_HALFPI - PTPE_PITCH_MARGIN)
+      bounds[1][1] = PBMATH_HALFPI - PTPE_PITCH_MARGIN;
+    // Run the genetic algorithm seeded with the center
+    stopReason = PTPEInitRun(that, dataset, PTPEModel5DOF, bounds, 
+      &end, center, bestAdnF);
+    // Next stage around the best adn with a smaller radius
+    VecCopy(center, bestAdnF);
+    radiusStage *= 0.5;
+    radiusScaleStage *= 0.5;
+  }
+  // Update the parameters if the average error has decreased
+  VecFloat* param = VecFloatCreate(PTPE_NBPARAM);
+  PTPEParam5DOFToParam(that, center, param);
+  float err = PTPEEvaluateParamDataset(that, param, dataset);
+  that->_stat._bestErr =
+    PTPEEvaluateParamDataset(that, that->_param, dataset);
+  if (err < that->_stat._bestErr) {
+    PTPESetParam(that, param);
+    that->_stat._bestErr = err;
+  }
+  VecFree(&param);
+  VecFree(&center);
+  VecFree(&bestAdnF);
+  // Refine the parameters if requested, the recalibration has neither
+  // time budget nor cancellation so the refinement has no deadline
+  if (that->_flagRefine)
+    that->_stat._bestErr = PTPERefineDeadline(that, dataset,
+      PTPE_REFINE_NBMAXITER, 0.0);
+  // Memorize the duration of the recalibration
+  that->_stat._elapsed = PTPEGetTime() - start;
+  // Return the reason of the end of the recalibration
+  return stopReason;
+}
+
+// Start the calibration of the estimator 'that' on a background
+// thread, with the same arguments as PTPEInitDataset
+// The calibration runs on a copy of the estimator and of 'dataset',
+// 'dataset' can be freed as soon as this function returns
+// When the calibration ends, its compiled projection is published
+// atomically and used from then by the queries (PTPEGetPxToMeter,
+// PTPEGetPolarToMeter, PTPEGetPxToMeterBatch) which never block and
+// never see partially updated parameters
+// The estimator must not be modified, only queried, until
+// PTPEBackgroundJoin is called
+// From the start, the queries use an immutable copy of the current
+// compiled projection, then the published one which stays in use
+// after PTPEBackgroundJoin, so queries can run during successive
+// background calibrations, until the estimator is compiled again (cf
+// PTPECompile)
+// PTPEBackgroundJoin and PTPECompile wait for the end of the queries
+// which may be using the projections they modify or free
+void PTPEBackgroundStart(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset,
+  const unsigned int nbEpoch, const float prec,
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (that->_background != NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg,
+      "'that' has already a background calibration");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'dataset' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset->_nb <= 2) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg,
+      "'dataset' doesn't have enough elements (%ld>2)", dataset->_nb);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (POVmin == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'POVmin' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (POVmax == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'POVmax' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Allocate memory
+  PTPEBackground* background =
+    PBErrMalloc(PixelToPosEstimatorErr, sizeof(PTPEBackground));
+  // Copy the estimator with its settings
+  background->_target = that;
+  background->_estimator =
+    PixelToPosEstimatorCreateStatic(&(that->_cameraPos),
+    &(that->_imgSize));
+  PTPESetParam(&(background->_estimator), that->_param);
+  background->_estimator._nbThread = that->_nbThread;
+  background->_estimator._flagRefine = that->_flagRefine;
+  background->_estimator._model = that->_model;
+  background->_estimator._nbIsland = that->_nbIsland;
+  background->_estimator._migrationPeriod = that->_migrationPeriod;
+  background->_estimator._stagnation = that->_stagnation;
+  background->_estimator._progress = that->_progress;
+  background->_estimator._progressData = that->_progressData;
+  // Copy the data set and the arguments
+  background->_dataset = PTPEDatasetCreate(dataset->_nb);
+  for (long iPos = 0; iPos < dataset->_nb; ++iPos)
+    PTPEDatasetAdd(background->_dataset, dataset->_pxX[iPos],
+      dataset->_pxY[iPos], dataset->_meterX[iPos],
+      dataset->_meterZ[iPos]);
+  background->_nbEpoch = nbEpoch;
+  background->_prec = prec;
+  background->_POVmin = *POVmin;
+  background->_POVmax = *POVmax;
+  atomic_init(&(background->_cancel), false);
+  atomic_init(&(background->_isDone), false);
+  background->_stopReason = PTPEStopReasonCancel;
+  background->_snapshot = NULL;
+  background->_replaced = NULL;
+  // The queries switch to an immutable copy of the compiled projection
+  // so the estimator's own one can be updated by PTPEBackgroundJoin
+  if (atomic_load(&(that->_live)) == NULL) {
+    PTPEProj buffer;
+    PTPEProj* snapshot =
+      PBErrMalloc(PixelToPosEstimatorErr, sizeof(PTPEProj));
+    unsigned int epoch = 0;
+    *snapshot = *PTPEGetProj(that, &buffer, &epoch);
+    PTPEReleaseProj(that, epoch);
+    atomic_store(&(that->_live), snapshot);
+  }
+  // Start the thread
+  if (pthread_create(&(background->_thread), NULL,
+    PTPEBackgroundMain, background) != 0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeOther;
+    sprintf(PixelToPosEstimatorErr->_msg,
+      "Can't create the background calibration thread");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  that->_background = background;
+}
+
+// Return true if the background calibration of the estimator 'that'
+// has ended (or if there is none), false else
+bool PTPEBackgroundIsDone(const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  if (that->_background == NULL)
+    return true;
+  return atomic_load_explicit(&(that->_background->_isDone),
+    memory_order_acquire);
+}
+
+// Request the cancellation of the background calibration of the
+// estimator 'that', the current projection is then kept
+void PTPEBackgroundCancel(PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  if (that->_background != NULL)
+    atomic_store(&(that->_background->_cancel), true);
+}
+
+// Wait for the end of the background calibration of the estimator
+// 'that' and copy its parameters and statistics into 'that'
+// Return the reason of the end of the background calibration
+PTPEStopReason PTPEBackgroundJoin(PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (that->_background == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg,
+      "'that' has no background calibration");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  PTPEBackground* background = that->_background;
+  pthread_join(background->_thread, NULL);
+  PTPEStopReason stopReason = background->_stopReason;
+  if (background->_snapshot != NULL) {
+    // The queries keep using the published projection, the parameters
+    // and compiled projection of the estimator are updated in place
+    // for its owner only, once the queries which loaded them before
+    // the switch to the copy have ended, as well as those using the
+    // projection published by a previous background calibration
+    PTPESynchronize(that);
+    free(background->_replaced);
+    VecCopy(that->_param, background->_estimator._param);
+    PTPEProjCompile(&(that->_proj), &(that->_cameraPos),
+      &(that->_imgSize), that->_param);
+    that->_stat = background->_estimator._stat;
+  }
   // Free memory
-  GenAlgFree(&ga);
+  PixelToPosEstimatorFreeStatic(&(background->_estimator));
+  PTPEDatasetFree(&(background->_dataset));
+  free(background);
+  that->_background = NULL;
+  // Return the reason of the end of the calibration
+  return stopReason;
 }
 
-// Convert the screen position to a real position
-VecFloat3D PTPEGetPxToMeter(
-  const PixelToPosEstimator* const that, 
-  const VecFloat2D* const screenPos) {
+// Set the policy of the estimator 'that' when PTPEInit stagnates to
+// 'policy'
+// PTPEInit stagnates when the relative improvement of its best value
+// over the last 'window' epochs is below 'minImprovement', or the
+// diversity of its populations (cf PTPEInitStat) is below
+// 'minDiversity'
+void PTPESetStagnation(PixelToPosEstimator* const that,
+  const PTPEStagnationPolicy policy, const unsigned int window,
+  const float minImprovement, const float minDiversity) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
     sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
     PBErrCatch(PixelToPosEstimatorErr);
   }
-  if (screenPos == NULL) {
+#endif
+  that->_stagnation._policy = policy;
+  that->_stagnation._window = window;
+  that->_stagnation._minImprovement = minImprovement;
+  that->_stagnation._minDiversity = minDiversity;
+}
+
+// Get the settings of the estimator 'that' when PTPEInit stagnates
+const PTPEStagnation* PTPEGetStagnation(
+  const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
     PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
-    sprintf(PixelToPosEstimatorErr->_msg, "'screenPos' is null");
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
     PBErrCatch(PixelToPosEstimatorErr);
   }
 #endif
-  // Declare a variable to memorize the result
-  VecFloat3D res = VecFloatCreateStatic3D();
-  // Calculate the real coordinates
-  VecFloat2D polarPos = PTPEGetPxToPolar(that, screenPos);
-  res = PTPEGetPolarToMeter(that, &polarPos);
-  // Return the result
-  return res;
+  return &(that->_stagnation);
+}
+
+// Set the function called by PTPEInit for the estimator 'that' each
+// time the calibration improves to 'progress', with the user data
+// 'data'
+// The function is called on the thread running the calibration
+// If 'progress' is null (default) the improvements are displayed on
+// stdout
+void PTPESetProgress(PixelToPosEstimator* const that,
+  const PTPEProgress progress, void* const data) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  that->_progress = progress;
+  that->_progressData = data;
 }
 
+// Return a description of the reason 'reason' of the end of PTPEInit
+const char* PTPEStopReasonToStr(const PTPEStopReason reason) {
+  switch (reason) {
+    case PTPEStopReasonPrec:
+      return "precision reached";
+    case PTPEStopReasonNbEpoch:
+      return "maximum number of epochs reached";
+    case PTPEStopReasonStagnation:
+      return "stagnation";
+    case PTPEStopReasonTimeBudget:
+      return "time budget elapsed";
+    case PTPEStopReasonCancel:
+      return "cancelled";
+    default:
+      return "unknown";
+  }
+}
+
+// Set the number of islands of the calibration by PTPEInit for the
+// estimator 'that' to 'nbIsland' (1 by default)
+void PTPESetNbIsland(PixelToPosEstimator* const that,
+  const int nbIsland) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (nbIsland < 1) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'nbIsland' is invalid (%d>=1)", nbIsland);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  that->_nbIsland = nbIsland;
+}
+
+// Get the number of islands of the calibration by PTPEInit for the
+// estimator 'that'
+int PTPEGetNbIsland(const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  return that->_nbIsland;
+}
+
+// Set the number of epochs between two migrations of the best adns
+// between islands in PTPEInit for the estimator 'that' to 'period'
+// (PTPE_MIGRATIONPERIOD by default, 0 for no migration)
+void PTPESetMigrationPeriod(PixelToPosEstimator* const that,
+  const unsigned int period) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  that->_migrationPeriod = period;
+}
+
+// Get the number of epochs between two migrations of the best adns
+// between islands in PTPEInit for the estimator 'that'
+unsigned int PTPEGetMigrationPeriod(
+  const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  return that->_migrationPeriod;
+}
+
+// Get the statistics of the last calibration by PTPEInit of the
+// estimator 'that'
+const PTPEInitStat* PTPEGetInitStat(
+  const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  return &(that->_stat);
+}
+
+// Get the ratio of evaluations avoided by the cache of the statistics
+// 'that'
+float PTPEInitStatGetCacheHitRate(const PTPEInitStat* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  unsigned long nb = that->_nbEval + that->_nbCacheHit;
+  if (nb == 0)
+    return 0.0;
+  return (float)(that->_nbCacheHit) / (float)nb;
+}
+
+// Set the flag to refine the result of the genetic algorithm in
+// PTPEInit with PTPERefine for the estimator 'that' to 'flag' (false
+// by default)
+void PTPESetFlagRefine(PixelToPosEstimator* const that, 
+  const bool flag) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  that->_flagRefine = flag;
+}
+
+// Get the flag to refine the result of the genetic algorithm in
+// PTPEInit for the estimator 'that'
+bool PTPEGetFlagRefine(const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  return that->_flagRefine;
+}
+
+// Set the model of the parameters searched by PTPEInit for the
+// estimator 'that' to 'model' (PTPEModelPOV by default)
+void PTPESetModel(PixelToPosEstimator* const that, 
+  const PTPEModel model) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  that->_model = model;
+}
+
+// Get the model of the parameters searched by PTPEInit for the
+// estimator 'that'
+PTPEModel PTPEGetModel(const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  return that->_model;
+}
+
+// Convert the parameters 'param5DOF' of the 5 degrees of freedom model
+// (yaw, pitch, roll, Sx, Sy) into the projection parameters 'param'
+// for the camera of the estimator 'that'
+// The view direction is (cos(pitch)sin(yaw), sin(pitch),
+// cos(pitch)cos(yaw)), the POV is at 1m from the camera in this
+// direction, and Up is the vertical orthogonalised relative to the
+// view direction and rotated by roll around it
+void PTPEParam5DOFToParam(const PixelToPosEstimator* const that,
+  const VecFloat* const param5DOF, VecFloat* const param) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param5DOF == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param5DOF' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (VecGetDim(param5DOF) != PTPE_NBPARAM5DOF) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'param5DOF' 's dimension is invalid (%d==%d)",
+      VecGetDim(param5DOF), PTPE_NBPARAM5DOF);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (VecGetDim(param) != PTPE_NBPARAM) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'param' 's dimension is invalid (%d==%d)",
+      VecGetDim(param), PTPE_NBPARAM);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  float cy = cos(VecGet(param5DOF, 0));
+  float sy = sin(VecGet(param5DOF, 0));
+  float cp = cos(VecGet(param5DOF, 1));
+  float sp = sin(VecGet(param5DOF, 1));
+  float cr = cos(VecGet(param5DOF, 2));
+  float sr = sin(VecGet(param5DOF, 2));
+  // View direction D
+  float D[3] = {cp * sy, sp, cp * cy};
+  // Vertical orthogonalised relative to D, U0, and D x U0
+  float U0[3] = {-1.0 * sp * sy, cp, -1.0 * sp * cy};
+  float DxU0[3] = {-1.0 * cy, 0.0, sy};
+  // POV and Up
+  for (int i = 3; i--;) {
+    VecSet(param, i, VecGet(&(that->_cameraPos), i) + D[i]);
+    VecSet(param, 5 + i, U0[i] * cr + DxU0[i] * sr);
+  }
+  // Angular scales
+  VecSet(param, 3, VecGet(param5DOF, 3));
+  VecSet(param, 4, VecGet(param5DOF, 4));
+}
+
+// Convert the projection parameters 'param' into the parameters
+// 'param5DOF' of the 5 degrees of freedom model (yaw, pitch, roll, Sx,
+// Sy) for the camera of the estimator 'that'
+// The conversion is exact if Up is orthogonal to the view direction,
+// else only the component of Up orthogonal to the view direction is
+// kept
+void PTPEParamToParam5DOF(const PixelToPosEstimator* const that,
+  const VecFloat* const param, VecFloat* const param5DOF) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param5DOF == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param5DOF' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (VecGetDim(param) != PTPE_NBPARAM) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'param' 's dimension is invalid (%d==%d)",
+      VecGetDim(param), PTPE_NBPARAM);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (VecGetDim(param5DOF) != PTPE_NBPARAM5DOF) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'param5DOF' 's dimension is invalid (%d==%d)",
+      VecGetDim(param5DOF), PTPE_NBPARAM5DOF);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // View direction D
+  VecFloat3D D = VecFloatCreateStatic3D();
+  for (int i = 3; i--;)
+    VecSet(&D, i, VecGet(param, i) - VecGet(&(that->_cameraPos), i));
+  VecNormalise(&D);
+  float yaw = atan2(VecGet(&D, 0), VecGet(&D, 2));
+  float sinPitch = VecGet(&D, 1);
+  if (sinPitch > 1.0)
+    sinPitch = 1.0;
+  else if (sinPitch < -1.0)
+    sinPitch = -1.0;
+  float pitch = asin(sinPitch);
+  // Component of Up orthogonal to D
+  VecFloat3D Up = VecFloatCreateStatic3D();
+  for (int i = 3; i--;)
+    VecSet(&Up, i, VecGet(param, 5 + i));
+  float dotUpD = VecDotProd(&Up, &D);
+  for (int i = 3; i--;)
+    VecSet(&Up, i, VecGet(&Up, i) - VecGet(&D, i) * dotUpD);
+  // Roll relative to the vertical orthogonalised relative to D, U0
+  float cy = cos(yaw);
+  float sy = sin(yaw);
+  float cp = cos(pitch);
+  float sp = sin(pitch);
+  float U0[3] = {-1.0 * sp * sy, cp, -1.0 * sp * cy};
+  float DxU0[3] = {-1.0 * cy, 0.0, sy};
+  float c = 0.0;
+  float s = 0.0;
+  for (int i = 3; i--;) {
+    c += VecGet(&Up, i) * U0[i];
+    s += VecGet(&Up, i) * DxU0[i];
+  }
+  VecSet(param5DOF, 0, yaw);
+  VecSet(param5DOF, 1, pitch);
+  VecSet(param5DOF, 2, atan2(s, c));
+  VecSet(param5DOF, 3, VecGet(param, 3));
+  VecSet(param5DOF, 4, VecGet(param, 4));
+}
+
+// Refine the current projection parameters of the estimator 'that'
+// with the Levenberg-Marquardt algorithm minimizing the sum of the
+// squared distances between the real positions and the estimated
+// positions of the data set 'dataset', using the analytic jacobian of
+// the projection relative to the 8 parameters
+// Stops after 'nbMaxIter' iterations or when the improvement stalls
+// The parameters are updated only if the average error decreases
+// Return the average error after refinement
+float PTPERefine(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const int nbMaxIter) {
+  return PTPERefineDeadline(that, dataset, nbMaxIter, 0.0);
+}
+
+// Same as PTPERefine but the iterations also stop at the time
+// 'deadline' (cf PTPEGetTime), 0 for no deadline
+static float PTPERefineDeadline(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const int nbMaxIter,
+  const double deadline) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'dataset' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Current parameters
+  double param[PTPE_NBPARAM];
+  for (int iParam = PTPE_NBPARAM; iParam--;)
+    param[iParam] = VecGet(that->_param, iParam);
+  // Damping factor
+  double lambda = 1e-3;
+  // Loop until the improvement stalls
+  double jtj[PTPE_NBPARAM][PTPE_NBPARAM];
+  double jtr[PTPE_NBPARAM];
+  double sse = PTPEGetSSE(that, dataset, param, jtj, jtr);
+  for (int iIter = 0; iIter < nbMaxIter && lambda < 1e10 &&
+    (deadline <= 0.0 || PTPEGetTime() < deadline); ++iIter) {
+    // Solve (J^t.J + lambda.diag(J^t.J)).delta = -J^t.r
+    double mat[PTPE_NBPARAM][PTPE_NBPARAM];
+    double vec[PTPE_NBPARAM];
+    double delta[PTPE_NBPARAM];
+    for (int i = PTPE_NBPARAM; i--;) {
+      for (int j = PTPE_NBPARAM; j--;)
+        mat[i][j] = jtj[i][j];
+      mat[i][i] += lambda * (jtj[i][i] > PBMATH_EPSILON ? 
+        jtj[i][i] : PBMATH_EPSILON);
+      vec[i] = -1.0 * jtr[i];
+    }
+    if (!PTPESolve8(mat, vec, delta)) {
+      lambda *= 10.0;
+      continue;
+    }
+    // Evaluate the candidate parameters
+    double candidate[PTPE_NBPARAM];
+    for (int iParam = PTPE_NBPARAM; iParam--;)
+      candidate[iParam] = param[iParam] + delta[iParam];
+    double sseCandidate = 
+      PTPEGetSSE(that, dataset, candidate, NULL, NULL);
+    if (sseCandidate < sse) {
+      // Accept the step
+      bool isStalled = ((sse - sseCandidate) < PTPE_REFINE_STALL * sse);
+      for (int iParam = PTPE_NBPARAM; iParam--;)
+        param[iParam] = candidate[iParam];
+      sse = PTPEGetSSE(that, dataset, param, jtj, jtr);
+      lambda *= 0.1;
+      if (isStalled)
+        break;
+    } else {
+      // Reject the step
+      lambda *= 10.0;
+    }
+  }
+  // Update the parameters if the average error has decreased
+  VecFloat* refined = VecFloatCreate(PTPE_NBPARAM);
+  for (int iParam = PTPE_NBPARAM; iParam--;)
+    VecSet(refined, iParam, param[iParam]);
+  float errRefined = PTPEEvaluateParamDataset(that, refined, dataset);
+  float err = PTPEEvaluateParamDataset(that, that->_param, dataset);
+  if (errRefined < err) {
+    PTPESetParam(that, refined);
+    err = errRefined;
+  }
+  VecFree(&refined);
+  // Return the average error
+  return err;
+}
+
+// Calculate the homography from the screen positions to the real
+// positions on the ground plane (y = 0) with the normalized direct
+// linear transformation, as an alternative to PTPEInit when the
+// ground is planar
+// Needs at least 4 correspondences, no 3 of them aligned
+// Return true if the homography could be calculated, false else
+bool PTPEInitHomography(PixelToPosEstimator* const that,
+  const GSet* const posMeter, const GSet* const posPixel) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Pack the correspondences
+  PTPEDataset* dataset = PTPEDatasetCreateFromGSet(posMeter, posPixel);
+  // Calculate the homography
+  bool ret = PTPEInitHomographyDataset(that, dataset);
+  // Free memory
+  PTPEDatasetFree(&dataset);
+  // Return the result
+  return ret;
+}
+
+// Same as PTPEInitHomography with the correspondences given as a
+// PTPEDataset
+bool PTPEInitHomographyDataset(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'dataset' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  if (dataset->_nb < 4)
+    return false;
+  // Normalize the screen and real positions
+  double scalePx = 0.0;
+  double offsetPx[2] = {0.0};
+  PTPEGetNormalization(dataset->_nb, dataset->_pxX, dataset->_pxY,
+    &scalePx, offsetPx);
+  double scaleMeter = 0.0;
+  double offsetMeter[2] = {0.0};
+  PTPEGetNormalization(dataset->_nb, dataset->_meterX, 
+    dataset->_meterZ, &scaleMeter, offsetMeter);
+  if (scalePx <= 0.0 || scaleMeter <= 0.0)
+    return false;
+  // Calculate A^t.A where each correspondence (x,y)->(u,v) gives the
+  // two rows of A:
+  // [-x, -y, -1, 0, 0, 0, u.x, u.y, u]
+  // [0, 0, 0, -x, -y, -1, v.x, v.y, v]
+  double ata[9][9] = {{0.0}};
+  for (long iPos = 0; iPos < dataset->_nb; ++iPos) {
+    double x = scalePx * dataset->_pxX[iPos] + offsetPx[0];
+    double y = scalePx * dataset->_pxY[iPos] + offsetPx[1];
+    double u = scaleMeter * dataset->_meterX[iPos] + offsetMeter[0];
+    double v = scaleMeter * dataset->_meterZ[iPos] + offsetMeter[1];
+    double rowU[9] = {-x, -y, -1.0, 0.0, 0.0, 0.0, u * x, u * y, u};
+    double rowV[9] = {0.0, 0.0, 0.0, -x, -y, -1.0, v * x, v * y, v};
+    for (int i = 9; i--;)
+      for (int j = i + 1; j--;)
+        ata[i][j] += rowU[i] * rowU[j] + rowV[i] * rowV[j];
+  }
+  for (int i = 9; i--;)
+    for (int j = i; j < 9; ++j)
+      ata[i][j] = ata[j][i];
+  // The normalized homography is the eigen vector of the smallest
+  // eigen value of A^t.A
+  double val[9];
+  double vec[9][9];
+  PTPEGetEigen9(ata, val, vec);
+  int iMin = 0;
+  int iMax = 0;
+  for (int i = 1; i < 9; ++i) {
+    if (val[i] < val[iMin])
+      iMin = i;
+    if (val[i] > val[iMax])
+      iMax = i;
+  }
+  // The solution must be unique (the second smallest eigen value must
+  // not be null), else the correspondences are degenerated
+  double secondMin = val[iMax];
+  for (int i = 9; i--;)
+    if (i != iMin && val[i] < secondMin)
+      secondMin = val[i];
+  if (secondMin <= PBMATH_EPSILON * val[iMax])
+    return false;
+  double hn[9];
+  for (int i = 9; i--;)
+    hn[i] = vec[i][iMin];
+  // Denormalize: H = Tmeter^-1 . Hn . Tpx
+  double tPx[3][3] = {
+    {scalePx, 0.0, offsetPx[0]},
+    {0.0, scalePx, offsetPx[1]},
+    {0.0, 0.0, 1.0}};
+  double invTMeter[3][3] = {
+    {1.0 / scaleMeter, 0.0, -offsetMeter[0] / scaleMeter},
+    {0.0, 1.0 / scaleMeter, -offsetMeter[1] / scaleMeter},
+    {0.0, 0.0, 1.0}};
+  double tmp[3][3] = {{0.0}};
+  for (int i = 3; i--;)
+    for (int j = 3; j--;)
+      for (int k = 3; k--;)
+        tmp[i][j] += hn[3 * i + k] * tPx[k][j];
+  double h[9] = {0.0};
+  for (int i = 3; i--;)
+    for (int j = 3; j--;)
+      for (int k = 3; k--;)
+        h[3 * i + j] += invTMeter[i][k] * tmp[k][j];
+  // Memorize the homography, scaled to a Frobenius norm equal to 1
+  // and signed to get w positive at the centroid of the screen
+  // positions, which are all in front of the camera (h[8] may be null
+  // if the origin of the screen is on the horizon line)
+  double norm = 0.0;
+  for (int i = 9; i--;)
+    norm += h[i] * h[i];
+  norm = sqrt(norm);
+  double w = h[6] * -offsetPx[0] / scalePx +
+    h[7] * -offsetPx[1] / scalePx + h[8];
+  if (w < 0.0)
+    norm = -norm;
+  for (int i = 9; i--;)
+    that->_homography[i] = h[i] / norm;
+  // Return the success
+  return true;
+}
+
+// Convert the screen position 'screenPos' to the real position
+// 'realPos' with the homography calculated by PTPEInitHomography
+// Return false if the screen position is on the horizon line of the
+// homography ('realPos' is then set to NaN), true else
+bool PTPEGetPxToMeterHomography(
+  const PixelToPosEstimator* const that,
+  const VecFloat2D* const screenPos, VecFloat3D* const realPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (screenPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'screenPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (realPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'realPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Apply the homography
+  const float* h = that->_homography;
+  float x = VecGet(screenPos, 0);
+  float y = VecGet(screenPos, 1);
+  float w = h[6] * x + h[7] * y + h[8];
+  // The points on the horizon line (w null relatively to its terms)
+  // are at infinity
+  if (fabs(w) < PBMATH_EPSILON *
+    (fabs(h[6] * x) + fabs(h[7] * y) + fabs(h[8]))) {
+    VecSet(realPos, 0, NAN);
+    VecSet(realPos, 1, NAN);
+    VecSet(realPos, 2, NAN);
+    return false;
+  }
+  VecSet(realPos, 0, (h[0] * x + h[1] * y + h[2]) / w);
+  VecSet(realPos, 1, 0.0);
+  VecSet(realPos, 2, (h[3] * x + h[4] * y + h[5]) / w);
+  // Return the success
+  return true;
+}
+
+// Calculate the similarity normalizing the 'nb' points ('x', 'y') 
+// (centroid at origin, average distance to origin equal to sqrt(2))
+// as 'scale' and 'offset' such as x' = scale * x + offset[0] and
+// y' = scale * y + offset[1]
+static void PTPEGetNormalization(const long nb, const float* const x,
+  const float* const y, double* const scale, double* const offset) {
+  // Centroid
+  double cx = 0.0;
+  double cy = 0.0;
+  for (long i = nb; i--;) {
+    cx += x[i];
+    cy += y[i];
+  }
+  cx /= (double)nb;
+  cy /= (double)nb;
+  // Average distance to the centroid
+  double dist = 0.0;
+  for (long i = nb; i--;)
+    dist += sqrt((x[i] - cx) * (x[i] - cx) + (y[i] - cy) * (y[i] - cy));
+  dist /= (double)nb;
+  if (dist < PBMATH_EPSILON) {
+    *scale = 0.0;
+    return;
+  }
+  *scale = sqrt(2.0) / dist;
+  offset[0] = -1.0 * *scale * cx;
+  offset[1] = -1.0 * *scale * cy;
+}
+
+// Calculate the eigen values 'val' and eigen vectors 'vec' (in
+// columns) of the symmetric 9x9 matrix 'mat' with the Jacobi
+// eigenvalue algorithm, 'mat' is modified
+static void PTPEGetEigen9(double mat[9][9], double val[9],
+  double vec[9][9]) {
+  // Init the eigen vectors to identity
+  for (int i = 9; i--;)
+    for (int j = 9; j--;)
+      vec[i][j] = (i == j ? 1.0 : 0.0);
+  // Loop on sweeps until the matrix is diagonal
+  for (int iSweep = 0; iSweep < PTPE_JACOBI_NBMAXSWEEP; ++iSweep) {
+    double off = 0.0;
+    double diag = 0.0;
+    for (int i = 9; i--;) {
+      diag += mat[i][i] * mat[i][i];
+      for (int j = i + 1; j < 9; ++j)
+        off += mat[i][j] * mat[i][j];
+    }
+    if (off <= 1e-30 * diag)
+      break;
+    // Cancel each off diagonal element with a Givens rotation
+    for (int p = 0; p < 8; ++p) {
+      for (int q = p + 1; q < 9; ++q) {
+        if (fabs(mat[p][q]) < 1e-300)
+          continue;
+        double theta = (mat[q][q] - mat[p][p]) / (2.0 * mat[p][q]);
+        double t = (theta >= 0.0 ? 1.0 : -1.0) /
+          (fabs(theta) + sqrt(theta * theta + 1.0));
+        double c = 1.0 / sqrt(t * t + 1.0);
+        double s = t * c;
+        for (int k = 9; k--;) {
+          double mkp = mat[k][p];
+          double mkq = mat[k][q];
+          mat[k][p] = c * mkp - s * mkq;
+          mat[k][q] = s * mkp + c * mkq;
+        }
+        for (int k = 9; k--;) {
+          double mpk = mat[p][k];
+          double mqk = mat[q][k];
+          mat[p][k] = c * mpk - s * mqk;
+          mat[q][k] = s * mpk + c * mqk;
+        }
+        for (int k = 9; k--;) {
+          double vkp = vec[k][p];
+          double vkq = vec[k][q];
+          vec[k][p] = c * vkp - s * vkq;
+          vec[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+  // Get the eigen values
+  for (int i = 9; i--;)
+    val[i] = mat[i][i];
+}
+
+// Convert the screen position to a real position
+VecFloat3D PTPEGetPxToMeter(
+  const PixelToPosEstimator* const that, 
+  const VecFloat2D* const screenPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (screenPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'screenPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Declare a variable to memorize the result
+  VecFloat3D res = VecFloatCreateStatic3D();
+  // Get the compiled projection
+  PTPEProj buffer;
+  unsigned int epoch = 0;
+  const PTPEProj* proj = PTPEGetProj(that, &buffer, &epoch);
+  // Calculate the real coordinates
+  PTPEProjGetAngleToMeter(proj,
+    proj->_kx * VecGet(screenPos, 0) + proj->_ox,
+    proj->_ky * VecGet(screenPos, 1) + proj->_oy,
+    res._val, res._val + 2);
+  PTPEReleaseProj(that, epoch);
+  // Return the result
+  return res;
+}
+
+
+// Build the compiled projection 'proj' from the camera position
+// 'cameraPos', the image dimensions 'imgSize' and the projection
+// parameters 'param'
+static void PTPEProjCompile(PTPEProj* const proj,
+  const VecFloat3D* const cameraPos, const VecFloat2D* const imgSize,
+  const VecFloat* const param) {
+  // Normalized vector Camera->POV
+  VecFloat3D CP = VecFloatCreateStatic3D();
+  for (int i = 3; i--;)
+    VecSet(&CP, i, VecGet(param, i) - VecGet(cameraPos, i));
+  VecNormalise(&CP);
+  // Normalized up vector
+  VecFloat3D Up = VecFloatCreateStatic3D();
+  for (int i = 3; i--;)
+    VecSet(&Up, i, VecGet(param, 5 + i));
+  VecNormalise(&Up);
+  // Normalized right vector
+  VecFloat3D Right = VecCrossProd(&CP, &Up);
+  VecNormalise(&Right);
+  // Vectors of the decomposition
+  VecFloat3D A = VecCrossProd(&Up, &CP);
+  VecFloat3D B = VecCrossProd(&Right, &CP);
+  float dotUpCP = VecDotProd(&Up, &CP);
+  for (int i = 3; i--;) {
+    proj->_c[i] = VecGet(cameraPos, i);
+    proj->_d[i] = VecGet(&CP, i);
+    proj->_a[i] = VecGet(&A, i);
+    proj->_b[i] = VecGet(&B, i);
+    proj->_f[i] = VecGet(&CP, i) - VecGet(&Up, i) * dotUpCP;
+  }
+  // Conversion from polar and screen positions to angles
+  proj->_sx = VecGet(param, 3);
+  proj->_sy = VecGet(param, 4);
+  proj->_kx = 2.0 * proj->_sx / VecGet(imgSize, 0);
+  proj->_ox = -1.0 * proj->_sx;
+  proj->_ky = 2.0 * proj->_sy / VecGet(imgSize, 1);
+  proj->_oy = -1.0 * proj->_sy;
+  // Memorize the parameters
+  for (int iParam = PTPE_NBPARAM; iParam--;)
+    proj->_param[iParam] = VecGet(param, iParam);
+  proj->_isValid = true;
+}
+
+// Return the compiled projection of the estimator 'that' if it is up
+// to date, else build it into 'buffer' and return 'buffer'
+// The query is registered in the parity 'epoch' of the epoch and the
+// returned projection stays valid until PTPEReleaseProj is called
+static const PTPEProj* PTPEGetProj(const PixelToPosEstimator* const that,
+  PTPEProj* const buffer, unsigned int* const epoch) {
+  // Register the query before loading the published projection (the
+  // sequentially consistent operations guarantee that PTPESynchronize
+  // waits for the queries which loaded a projection before its call)
+  atomic_long* nbQuery = (atomic_long*)(that->_nbQuery);
+  *epoch = atomic_load(&(that->_epoch)) & 1;
+  atomic_fetch_add(nbQuery + *epoch, 1);
+  const PTPEProj* live = atomic_load(&(that->_live));
+  if (live != NULL)
+    return live;
+  if (PTPEIsCompiled(that))
+    return &(that->_proj);
+  PTPEProjCompile(buffer, &(that->_cameraPos), &(that->_imgSize),
+    that->_param);
+  return buffer;
+}
+
+// End the query of the estimator 'that' registered in the parity
+// 'epoch' of the epoch by PTPEGetProj
+static void PTPEReleaseProj(const PixelToPosEstimator* const that,
+  const unsigned int epoch) {
+  atomic_long* nbQuery = (atomic_long*)(that->_nbQuery);
+  atomic_fetch_sub(nbQuery + epoch, 1);
+}
+
+// Wait for the end of the queries of the estimator 'that' which may
+// be using the projection it published before the call, or its own
+// one if none was published
+static void PTPESynchronize(PixelToPosEstimator* const that) {
+  // The queries registered before the call are counted in one of the
+  // two parities, each one is seen empty once after the call: first
+  // the previous parity, which only receives the queries which read
+  // the epoch before its last change, then the current one after the
+  // change of epoch sends the new queries to the previous parity
+  unsigned int epoch = atomic_load(&(that->_epoch)) & 1;
+  while (atomic_load(that->_nbQuery + (epoch ^ 1)) != 0)
+    sched_yield();
+  atomic_fetch_add(&(that->_epoch), 1);
+  while (atomic_load(that->_nbQuery + epoch) != 0)
+    sched_yield();
+}
+
+// Convert the rotation angles ('thetaX', 'thetaY') to the real
+// position ('x', 0.0, 'z') with the compiled projection 'proj'
+static void PTPEProjGetAngleToMeter(const PTPEProj* const proj,
+  const float thetaX, const float thetaY, float* const x,
+  float* const z) {
+  float c1 = cos(thetaX) - 1.0;
+  float s1 = sin(thetaX);
+  float c2 = cos(thetaY);
+  float s2 = sin(thetaY);
+  // Vector from the camera to the point
+  float v[3];
+  for (int i = 3; i--;)
+    v[i] = proj->_f[i] * c1 + proj->_d[i] * c2 +
+      proj->_a[i] * s1 + proj->_b[i] * s2;
+  // Projection to ground plane
+  float a = proj->_c[1] / v[1];
+  *x = proj->_c[0] - a * v[0];
+  *z = proj->_c[2] - a * v[2];
+}
+
+// Create a compiled projection from the camera position 'cameraPos',
+// the image dimensions 'imgSize' and the projection parameters 'param'
+PTPEProj PTPEProjCreateStatic(const VecFloat3D* const cameraPos,
+  const VecFloat2D* const imgSize, const VecFloat* const param) {
+#if BUILDMODE == 0
+  if (cameraPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'cameraPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (imgSize == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'imgSize' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Declare the new compiled projection
+  PTPEProj proj;
+  // Build the compiled projection
+  PTPEProjCompile(&proj, cameraPos, imgSize, param);
+  // Return the new compiled projection
+  return proj;
+}
+
+// Convert the screen position to a real position with the compiled
+// projection 'that'
+VecFloat3D PTPEProjGetPxToMeter(const PTPEProj* const that,
+  const VecFloat2D* const screenPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (screenPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'screenPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Declare a variable to memorize the result
+  VecFloat3D res = VecFloatCreateStatic3D();
+  // Calculate the real coordinates
+  PTPEProjGetAngleToMeter(that,
+    that->_kx * VecGet(screenPos, 0) + that->_ox,
+    that->_ky * VecGet(screenPos, 1) + that->_oy,
+    res._val, res._val + 2);
+  // Return the result
+  return res;
+}
+
+// Convert the screen position to a real position with the projection
+// parameters 'param' instead of those of the estimator 'that'
+// Only the camera position and image dimensions of 'that' are used,
+// 'that' is not modified
+VecFloat3D PTPEGetPxToMeterWithParam(
+  const PixelToPosEstimator* const that, const VecFloat* const param,
+  const VecFloat2D* const screenPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  PTPEProj proj = PTPEProjCreateStatic(&(that->_cameraPos),
+    &(that->_imgSize), param);
+  return PTPEProjGetPxToMeter(&proj, screenPos);
+}
+
+// Return the average distance between the real positions 'posMeter'
+// and the real positions estimated from the screen positions
+// 'posPixel' with the projection parameters 'param'
+// Only the camera position and image dimensions of 'that' are used,
+// 'that' is not modified, so several threads can evaluate parameters
+// concurrently while the estimator is used
+float PTPEEvaluateParam(const PixelToPosEstimator* const that,
+  const VecFloat* const param, const GSet* const posMeter,
+  const GSet* const posPixel) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (posMeter == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'posMeter' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (posPixel == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'posPixel' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (GSetNbElem(posPixel) != GSetNbElem(posMeter)) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'posPixel' and 'posMeter' don't have same sizes (%ld==%ld)",
+      GSetNbElem(posPixel), GSetNbElem(posMeter));
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  if (GSetNbElem(posMeter) == 0)
+    return 0.0;
+  // Compile the projection
+  PTPEProj proj = PTPEProjCreateStatic(&(that->_cameraPos),
+    &(that->_imgSize), param);
+  // Variable to memorize the evaluation
+  float ev = 0.0;
+  // Loop on both sets
+  GSetIterForward iterMeter = GSetIterForwardCreateStatic(posMeter);
+  GSetIterForward iterPixel = GSetIterForwardCreateStatic(posPixel);
+  do {
+    // Convert the screen position to real position
+    VecFloat3D pEstim = 
+      PTPEProjGetPxToMeter(&proj, GSetIterGet(&iterPixel));
+    // Calculate the error with the correct real position
+    ev += VecDist((VecFloat3D*)GSetIterGet(&iterMeter), &pEstim);
+  } while (GSetIterStep(&iterMeter) && GSetIterStep(&iterPixel));
+  // Return the average error
+  return ev / (float)GSetNbElem(posMeter);
+}
+
+// Return the average distance between the real positions and the real
+// positions estimated from the screen positions of the data set
+// 'dataset' with the projection parameters 'param', or HUGE_VAL if
+// the parameters are degenerated and the distance is not a number
+// Only the camera position and image dimensions of 'that' are used,
+// 'that' is not modified
+float PTPEEvaluateParamDataset(const PixelToPosEstimator* const that,
+  const VecFloat* const param, const PTPEDataset* const dataset) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'dataset' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Evaluate without cutoff
+  return PTPEEvaluateParamDatasetBounded(that, param, dataset, 
+    HUGE_VAL, NULL);
+}
+
+// Same as PTPEEvaluateParamDataset but the evaluation stops as soon as
+// the average distance is known to be greater than 'cutoff'
+// If the evaluation stops, 'isRejected' is set to true and the
+// returned value is a lower bound of the average distance, else
+// 'isRejected' is set to false and the returned value is the same as
+// PTPEEvaluateParamDataset
+// 'isRejected' can be null
+float PTPEEvaluateParamDatasetBounded(
+  const PixelToPosEstimator* const that, const VecFloat* const param, 
+  const PTPEDataset* const dataset, const float cutoff,
+  bool* const isRejected) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'dataset' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  if (isRejected != NULL)
+    *isRejected = false;
+  if (dataset->_nb == 0)
+    return 0.0;
+  // Compile the projection
+  PTPEProj proj = PTPEProjCreateStatic(&(that->_cameraPos),
+    &(that->_imgSize), param);
+  // Variable to memorize the evaluation
+  float ev = 0.0;
+  // Sum of the distances above which the evaluation stops, and number
+  // of correspondences between two comparisons with it
+  float maxEv = cutoff * (float)(dataset->_nb);
+  long blockSize = (isinf(cutoff) ? 
+    PTPE_EVALBLOCKSIZE : PTPE_EVALBOUNDEDBLOCKSIZE);
+  // Loop on blocks of correspondences
+  float meterX[PTPE_EVALBLOCKSIZE];
+  float meterZ[PTPE_EVALBLOCKSIZE];
+  for (long iPos = 0; iPos < dataset->_nb; iPos += blockSize) {
+    long nb = dataset->_nb - iPos;
+    if (nb > blockSize)
+      nb = blockSize;
+    // Convert the screen positions to real positions
+    PTPEProjGetPxToMeterBatch(&proj, nb, dataset->_pxX + iPos,
+      dataset->_pxY + iPos, meterX, meterZ);
+    // Calculate the error with the correct real positions
+    for (long i = 0; i < nb; ++i) {
+      float dx = meterX[i] - dataset->_meterX[iPos + i];
+      float dz = meterZ[i] - dataset->_meterZ[iPos + i];
+      ev += sqrt(dx * dx + dz * dz);
+    }
+    // Stop if the average error can't be below the cutoff anymore
+    if (ev > maxEv) {
+      if (isRejected != NULL)
+        *isRejected = true;
+      break;
+    }
+  }
+  // If the evaluation is not a number, return an infinite error to
+  // reject these parameters (as PTPEGetSSE), so the evaluations can be
+  // sorted
+  if (isnan(ev))
+    return HUGE_VAL;
+  // Return the average error
+  return ev / (float)(dataset->_nb);
+}
+
+// Create a new empty PTPEDataset able to contain 'capacity'
+// correspondences without reallocation
+PTPEDataset* PTPEDatasetCreate(const long capacity) {
+#if BUILDMODE == 0
+  if (capacity < 0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'capacity' is invalid (%ld>=0)", capacity);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Allocate memory
+  PTPEDataset* dataset = 
+    PBErrMalloc(PixelToPosEstimatorErr, sizeof(PTPEDataset));
+  dataset->_nb = 0;
+  dataset->_capacity = 0;
+  dataset->_pxX = NULL;
+  dataset->_pxY = NULL;
+  dataset->_meterX = NULL;
+  dataset->_meterZ = NULL;
+  dataset->_isView = false;
+  PTPEDatasetReserve(dataset, capacity);
+  // Return the new data set
+  return dataset;
+}
+
+// Create a new PTPEDataset from the real positions 'posMeter'
+// (VecFloat3D) and the screen positions 'posPixel' (VecFloat2D)
+PTPEDataset* PTPEDatasetCreateFromGSet(const GSet* const posMeter,
+  const GSet* const posPixel) {
+#if BUILDMODE == 0
+  if (posMeter == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'posMeter' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (posPixel == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'posPixel' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (GSetNbElem(posPixel) != GSetNbElem(posMeter)) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'posPixel' and 'posMeter' don't have same sizes (%ld==%ld)",
+      GSetNbElem(posPixel), GSetNbElem(posMeter));
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Create the data set
+  PTPEDataset* dataset = PTPEDatasetCreate(GSetNbElem(posMeter));
+  if (GSetNbElem(posMeter) == 0)
+    return dataset;
+  // Loop on both sets
+  GSetIterForward iterMeter = GSetIterForwardCreateStatic(posMeter);
+  GSetIterForward iterPixel = GSetIterForwardCreateStatic(posPixel);
+  do {
+    VecFloat3D* pMeter = GSetIterGet(&iterMeter);
+    VecFloat2D* pPixel = GSetIterGet(&iterPixel);
+    PTPEDatasetAdd(dataset, VecGet(pPixel, 0), VecGet(pPixel, 1),
+      VecGet(pMeter, 0), VecGet(pMeter, 2));
+  } while (GSetIterStep(&iterMeter) && GSetIterStep(&iterPixel));
+  // Return the new data set
+  return dataset;
+}
+
+// Free memory used by the PTPEDataset 'that'
+void PTPEDatasetFree(PTPEDataset** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  if (!((*that)->_isView))
+    free((*that)->_pxX);
+  free(*that);
+  *that = NULL;
+}
+
+// Add the correspondence between the screen position ('pxX', 'pxY')
+// and the real position ('meterX', 0.0, 'meterZ') to the PTPEDataset
+// 'that'
+void PTPEDatasetAdd(PTPEDataset* const that, const float pxX,
+  const float pxY, const float meterX, const float meterZ) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Grow the arrays if necessary
+  if (that->_nb == that->_capacity)
+    PTPEDatasetReserve(that, 
+      (that->_capacity < 16 ? 32 : 2 * that->_capacity));
+  // Add the correspondence
+  that->_pxX[that->_nb] = pxX;
+  that->_pxY[that->_nb] = pxY;
+  that->_meterX[that->_nb] = meterX;
+  that->_meterZ[that->_nb] = meterZ;
+  ++(that->_nb);
+}
+
+// Remove the correspondence at index 'iPos' from the PTPEDataset
+// 'that', the following correspondences keep their order
+void PTPEDatasetRemove(PTPEDataset* const that, const long iPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (iPos < 0 || iPos >= that->_nb) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'iPos' is invalid (0<=%ld<%ld)", iPos, that->_nb);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Shift the following correspondences
+  size_t size = sizeof(float) * (that->_nb - iPos - 1);
+  memmove(that->_pxX + iPos, that->_pxX + iPos + 1, size);
+  memmove(that->_pxY + iPos, that->_pxY + iPos + 1, size);
+  memmove(that->_meterX + iPos, that->_meterX + iPos + 1, size);
+  memmove(that->_meterZ + iPos, that->_meterZ + iPos + 1, size);
+  --(that->_nb);
+}
+
+// Get the number of correspondences in the PTPEDataset 'that'
+long PTPEDatasetGetNb(const PTPEDataset* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  return that->_nb;
+}
+
+// Create a synthetic PTPEDataset of 'nb' correspondences with the
+// projection of the estimator 'that' as ground truth
+// The screen positions are drawn uniformly over the pixels of the
+// image viewing the ground within 'maxDist' meters of the camera,
+// their real positions are given by the projection, then a gaussian
+// noise of standard deviation 'noise' pixels is added to the screen
+// positions
+// A ratio 'outlierRatio' of the correspondences are outliers, their
+// screen position is drawn uniformly over the image independently of
+// their real position
+// 'seed' is the state of the random number generator (cf rand_r)
+// Return NULL if the image doesn't view enough of the ground (cf
+// PTPE_SYNTHETIC_NBMAXTRY)
+PTPEDataset* PTPEDatasetCreateSynthetic(
+  const PixelToPosEstimator* const that, const long nb,
+  const float noise, const float outlierRatio, const float maxDist,
+  unsigned int* const seed) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (nb < 0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, "'nb' is invalid (%ld>=0)",
+      nb);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (noise < 0.0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg,
+      "'noise' is invalid (%f>=0)", noise);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (outlierRatio < 0.0 || outlierRatio > 1.0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg,
+      "'outlierRatio' is invalid (0<=%f<=1)", outlierRatio);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (seed == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'seed' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Get a copy of the compiled projection and its inverse
+  PTPEProj buffer;
+  unsigned int epoch = 0;
+  PTPEProj copy = *PTPEGetProj(that, &buffer, &epoch);
+  PTPEReleaseProj(that, epoch);
+  const PTPEProj* proj = &copy;
+  PTPEProjInv inv;
+  PTPEProjInvCompile(&inv, proj);
+  // Create the data set
+  PTPEDataset* dataset = PTPEDatasetCreate(nb);
+  float w = VecGet(&(that->_imgSize), 0);
+  float h = VecGet(&(that->_imgSize), 1);
+  long nbTry = 0;
+  while (dataset->_nb < nb) {
+    if (nbTry++ >= PTPE_SYNTHETIC_NBMAXTRY * nb) {
+      PTPEDatasetFree(&dataset);
+      return NULL;
+    }
+    // Draw a screen position and get its real position, keep it only
+    // if it's on the ground in front of the camera within the maximum
+    // distance
+    float pxX = w * (float)rand_r(seed) / (float)RAND_MAX;
+    float pxY = h * (float)rand_r(seed) / (float)RAND_MAX;
+    float meterX = 0.0;
+    float meterZ = 0.0;
+    PTPEProjGetAngleToMeter(proj, proj->_kx * pxX + proj->_ox,
+      proj->_ky * pxY + proj->_oy, &meterX, &meterZ);
+    float checkX = 0.0;
+    float checkY = 0.0;
+    if (!PTPEProjGetMeterToPx(proj, &inv, meterX, meterZ,
+      &checkX, &checkY) ||
+      fastpow(meterX - proj->_c[0], 2) + fastpow(meterZ - proj->_c[2], 2) >
+      fastpow(maxDist, 2))
+      continue;
+    // Add the gaussian noise (Box-Muller transform)
+    if (noise > 0.0) {
+      float u = ((float)rand_r(seed) + 1.0) / ((float)RAND_MAX + 1.0);
+      float v = (float)rand_r(seed) / (float)RAND_MAX;
+      float r = noise * sqrt(-2.0 * log(u));
+      pxX += r * cos(PBMATH_TWOPI * v);
+      pxY += r * sin(PBMATH_TWOPI * v);
+    }
+    // Replace the screen position of the outliers
+    if (outlierRatio > 0.0 &&
+      (float)rand_r(seed) / (float)RAND_MAX < outlierRatio) {
+      pxX = w * (float)rand_r(seed) / (float)RAND_MAX;
+      pxY = h * (float)rand_r(seed) / (float)RAND_MAX;
+    }
+    PTPEDatasetAdd(dataset, pxX, pxY, meterX, meterZ);
+  }
+  // Return the new data set
+  return dataset;
+}
+
+// Reallocate the arrays of the PTPEDataset 'that' to contain
+// 'capacity' correspondences, the four arrays are allocated in one
+// aligned block
+static void PTPEDatasetReserve(PTPEDataset* const that,
+  const long capacity) {
+  if (capacity <= that->_capacity)
+    return;
+  // Round the capacity to keep each array aligned
+  long nbPerAlign = PTPE_DATASET_ALIGN / sizeof(float);
+  long cap = (capacity + nbPerAlign - 1) / nbPerAlign * nbPerAlign;
+  float* block = NULL;
+  if (posix_memalign((void**)&block, PTPE_DATASET_ALIGN,
+    sizeof(float) * 4 * cap) != 0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeMallocFailed;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "Can't allocate the data set (%ld)", cap);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  // Copy the current correspondences
+  if (that->_nb > 0) {
+    memcpy(block, that->_pxX, sizeof(float) * that->_nb);
+    memcpy(block + cap, that->_pxY, sizeof(float) * that->_nb);
+    memcpy(block + 2 * cap, that->_meterX, sizeof(float) * that->_nb);
+    memcpy(block + 3 * cap, that->_meterZ, sizeof(float) * that->_nb);
+  }
+  if (!(that->_isView))
+    free(that->_pxX);
+  that->_isView = false;
+  that->_pxX = block;
+  that->_pxY = block + cap;
+  that->_meterX = block + 2 * cap;
+  that->_meterZ = block + 3 * cap;
+  that->_capacity = cap;
+}
+
+// Create a new PTPEDataset of 'nb' correspondences using the arrays
+// stored one after the other every 'stride' floats from 'arrays'
+// without copying them
+static PTPEDataset* PTPEDatasetCreateView(const long nb,
+  float* const arrays, const long stride) {
+  PTPEDataset* dataset =
+    PBErrMalloc(PixelToPosEstimatorErr, sizeof(PTPEDataset));
+  dataset->_nb = nb;
+  dataset->_capacity = nb;
+  dataset->_pxX = arrays;
+  dataset->_pxY = arrays + stride;
+  dataset->_meterX = arrays + 2 * stride;
+  dataset->_meterZ = arrays + 3 * stride;
+  dataset->_isView = true;
+  return dataset;
+}
+
+// Read the input of the calibration from the text file 'stream': the
+// camera position, image dimensions, POVmin and POVmax as vectors
+// (cf VecLoad), then the number of correspondences for the calibration
+// followed by the real (VecFloat3D) and screen (VecFloat2D) positions
+// of each of them, and the same for the test
+// Return NULL if the file is invalid
+PTPEInput* PTPEInputLoadText(FILE* const stream) {
+#if BUILDMODE == 0
+  if (stream == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'stream' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Allocate memory
+  PTPEInput* input = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(PTPEInput));
+  input->_input = NULL;
+  input->_test = NULL;
+  input->_data = NULL;
+  input->_size = 0;
+  // Read the camera, image dimensions and bounds
+  VecFloat* v[4] = {NULL, NULL, NULL, NULL};
+  int dim[4] = {3, 2, 3, 3};
+  bool isValid = true;
+  for (int i = 0; isValid && i < 4; ++i)
+    isValid = VecLoad(v + i, stream) && VecGetDim(v[i]) == dim[i];
+  if (isValid) {
+    input->_cameraPos = VecFloatCreateStatic3D();
+    input->_imgSize = VecFloatCreateStatic2D();
+    input->_POVmin = VecFloatCreateStatic3D();
+    input->_POVmax = VecFloatCreateStatic3D();
+    VecCopy(&(input->_cameraPos), v[0]);
+    VecCopy(&(input->_imgSize), v[1]);
+    VecCopy(&(input->_POVmin), v[2]);
+    VecCopy(&(input->_POVmax), v[3]);
+  }
+  for (int i = 4; i--;)
+    VecFree(v + i);
+  // Read the correspondences
+  int nb = 0;
+  if (isValid)
+    isValid = (fscanf(stream, "%d", &nb) == 1 && nb >= 0);
+  if (isValid) {
+    input->_input = PTPEDatasetCreate(nb);
+    isValid = PTPEInputLoadTextDataset(input->_input, nb, stream);
+  }
+  if (isValid)
+    isValid = (fscanf(stream, "%d", &nb) == 1 && nb >= 0);
+  if (isValid) {
+    input->_test = PTPEDatasetCreate(nb);
+    isValid = PTPEInputLoadTextDataset(input->_test, nb, stream);
+  }
+  if (!isValid)
+    PTPEInputFree(&input);
+  // Return the input
+  return input;
+}
+
+// Read 'nb' correspondences from the text file 'stream' into the
+// PTPEDataset 'that'
+// Return true if the correspondences could be read, false else
+static bool PTPEInputLoadTextDataset(PTPEDataset* const that,
+  const int nb, FILE* const stream) {
+  bool isValid = true;
+  for (int iPos = 0; isValid && iPos < nb; ++iPos) {
+    VecFloat* posMeter = NULL;
+    VecFloat* posPixel = NULL;
+    isValid = VecLoad(&posMeter, stream) && VecLoad(&posPixel, stream) &&
+      VecGetDim(posMeter) == 3 && VecGetDim(posPixel) == 2;
+    if (isValid)
+      PTPEDatasetAdd(that, VecGet(posPixel, 0), VecGet(posPixel, 1),
+        VecGet(posMeter, 0), VecGet(posMeter, 2));
+    VecFree(&posMeter);
+    VecFree(&posPixel);
+  }
+  return isValid;
+}
+
+// Write the input of the calibration 'that' into the text file
+// 'stream' (cf PTPEInputLoadText)
+// Return true if the input could be written, false else
+bool PTPEInputSaveText(const PTPEInput* const that, FILE* const stream) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (stream == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'stream' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Write the camera, image dimensions and bounds
+  const VecFloat* v[4] = {(const VecFloat*)&(that->_cameraPos),
+    (const VecFloat*)&(that->_imgSize), (const VecFloat*)&(that->_POVmin),
+    (const VecFloat*)&(that->_POVmax)};
+  bool isValid = true;
+  for (int i = 0; isValid && i < 4; ++i) {
+    float val[3];
+    for (int j = VecGetDim(v[i]); j--;)
+      val[j] = VecGet(v[i], j);
+    isValid = PTPEInputSaveTextVec(stream, VecGetDim(v[i]), val);
+  }
+  // Write the correspondences
+  if (isValid)
+    isValid = PTPEInputSaveTextDataset(that->_input, stream);
+  if (isValid)
+    isValid = PTPEInputSaveTextDataset(that->_test, stream);
+  return isValid;
+}
+
+// Write the 'dim' values 'val' as a vector into the text file 'stream'
+// (cf VecLoad)
+// Return true if the vector could be written, false else
+static bool PTPEInputSaveTextVec(FILE* const stream, const int dim,
+  const float* const val) {
+  if (fprintf(stream, "{\n  \"_dim\":\"%d\",\n  \"_val\":[", dim) < 0)
+    return false;
+  for (int i = 0; i < dim; ++i)
+    if (fprintf(stream, "%s\"%f\"", (i == 0 ? "" : ","), val[i]) < 0)
+      return false;
+  return (fprintf(stream, "]\n}\n") >= 0);
+}
+
+// Write the number of correspondences and the correspondences of the
+// PTPEDataset 'that' into the text file 'stream'
+// Return true if they could be written, false else
+static bool PTPEInputSaveTextDataset(const PTPEDataset* const that,
+  FILE* const stream) {
+  bool isValid = (fprintf(stream, "%ld\n", that->_nb) >= 0);
+  for (long iPos = 0; isValid && iPos < that->_nb; ++iPos) {
+    float posMeter[3] = {that->_meterX[iPos], 0.0, that->_meterZ[iPos]};
+    float posPixel[2] = {that->_pxX[iPos], that->_pxY[iPos]};
+    isValid = PTPEInputSaveTextVec(stream, 3, posMeter) &&
+      PTPEInputSaveTextVec(stream, 2, posPixel);
+  }
+  return isValid;
+}
+
+// Return the number of floats occupied by an array of 'nb' floats in
+// a binary input file, padded to keep the next array aligned
+static long PTPEInputGetStride(const long nb) {
+  long nbPerAlign = PTPE_DATASET_ALIGN / sizeof(float);
+  return (nb + nbPerAlign - 1) / nbPerAlign * nbPerAlign;
+}
+
+// Save the input of the calibration 'that' into the binary file at
+// 'path': a header with the camera position, image dimensions and
+// bounds, followed by the packed and aligned arrays of the screen
+// and real positions of the calibration and test data sets
+// The file uses the byte order of the machine
+// Return true if the input could be saved, false else
+bool PTPEInputSave(const PTPEInput* const that, const char* const path) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (path == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'path' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Set the header
+  PTPEInputHeader header;
+  memset(&header, 0, sizeof(PTPEInputHeader));
+  strcpy(header._magic, PTPE_INPUT_MAGIC);
+  header._version = PTPE_INPUT_VERSION;
+  header._nbInput = that->_input->_nb;
+  header._nbTest = that->_test->_nb;
+  for (int i = 3; i--;) {
+    header._cameraPos[i] = VecGet(&(that->_cameraPos), i);
+    header._POVmin[i] = VecGet(&(that->_POVmin), i);
+    header._POVmax[i] = VecGet(&(that->_POVmax), i);
+  }
+  for (int i = 2; i--;)
+    header._imgSize[i] = VecGet(&(that->_imgSize), i);
+  // Write the header and the arrays
+  FILE* stream = fopen(path, "wb");
+  if (stream == NULL)
+    return false;
+  bool ret =
+    (fwrite(&header, sizeof(PTPEInputHeader), 1, stream) == 1) &&
+    PTPEInputSaveDataset(that->_input, stream) &&
+    PTPEInputSaveDataset(that->_test, stream);
+  if (fclose(stream) != 0)
+    ret = false;
+  return ret;
+}
+
+// Write the arrays of the PTPEDataset 'that' in the binary input
+// file 'stream'
+// Return true if the arrays could be written, false else
+static bool PTPEInputSaveDataset(const PTPEDataset* const that,
+  FILE* const stream) {
+  const float* arrays[4] =
+    {that->_pxX, that->_pxY, that->_meterX, that->_meterZ};
+  float pad[PTPE_DATASET_ALIGN / sizeof(float)] = {0.0};
+  size_t nbPad = PTPEInputGetStride(that->_nb) - that->_nb;
+  for (int iArr = 0; iArr < 4; ++iArr)
+    if (fwrite(arrays[iArr], sizeof(float), that->_nb, stream) !=
+      (size_t)(that->_nb) ||
+      fwrite(pad, sizeof(float), nbPad, stream) != nbPad)
+      return false;
+  return true;
+}
+
+// Memory map the binary input file at 'path' (cf PTPEInputSave), the
+// data sets use the mapped arrays without copy
+// Return NULL if the file can't be mapped or isn't a valid binary
+// input file
+PTPEInput* PTPEInputLoad(const char* const path) {
+#if BUILDMODE == 0
+  if (path == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'path' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Map the file, privately as the data sets may be modified
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+    (size_t)st.st_size < sizeof(PTPEInputHeader)) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = st.st_size;
+  void* data =
+    mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return NULL;
+  // Check the header
+  const PTPEInputHeader* header = data;
+  long strideInput = PTPEInputGetStride(header->_nbInput);
+  long strideTest = PTPEInputGetStride(header->_nbTest);
+  bool isValid =
+    (strncmp(header->_magic, PTPE_INPUT_MAGIC, 8) == 0) &&
+    header->_version == PTPE_INPUT_VERSION &&
+    size == sizeof(PTPEInputHeader) +
+      sizeof(float) * 4 * (strideInput + strideTest);
+  if (!isValid) {
+    munmap(data, size);
+    return NULL;
+  }
+  // Create the input
+  PTPEInput* input = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(PTPEInput));
+  input->_cameraPos = VecFloatCreateStatic3D();
+  input->_imgSize = VecFloatCreateStatic2D();
+  input->_POVmin = VecFloatCreateStatic3D();
+  input->_POVmax = VecFloatCreateStatic3D();
+  for (int i = 3; i--;) {
+    VecSet(&(input->_cameraPos), i, header->_cameraPos[i]);
+    VecSet(&(input->_POVmin), i, header->_POVmin[i]);
+    VecSet(&(input->_POVmax), i, header->_POVmax[i]);
+  }
+  for (int i = 2; i--;)
+    VecSet(&(input->_imgSize), i, header->_imgSize[i]);
+  float* arrays = (float*)((char*)data + sizeof(PTPEInputHeader));
+  input->_input =
+    PTPEDatasetCreateView(header->_nbInput, arrays, strideInput);
+  input->_test = PTPEDatasetCreateView(header->_nbTest,
+    arrays + 4 * strideInput, strideTest);
+  input->_data = data;
+  input->_size = size;
+  // Return the input
+  return input;
+}
+
+// Free memory used by the input of the calibration 'that'
+void PTPEInputFree(PTPEInput** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  PTPEDatasetFree(&((*that)->_input));
+  PTPEDatasetFree(&((*that)->_test));
+  if ((*that)->_data != NULL)
+    munmap((*that)->_data, (*that)->_size);
+  free(*that);
+  *that = NULL;
+}
+
+// Compile the projection of the estimator 'that' from its current
+// projection parameters and camera position
+// Must be called again if '_cameraPos' or '_imgSize' are modified
+// Modifications of '_param' are detected automatically, the
+// conversions then fall back to the non compiled (slower) projection
+// until the next call to PTPECompile
+void PTPECompile(PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  PTPEProjCompile(&(that->_proj), &(that->_cameraPos),
+    &(that->_imgSize), that->_param);
+  // The queries switch back from the projection published by the
+  // background calibration, if any, to the estimator's own one, the
+  // published one is freed once the queries using it have ended
+  PTPEProj* live = (PTPEProj*)atomic_exchange(&(that->_live), NULL);
+  if (live != NULL) {
+    PTPESynchronize(that);
+    free(live);
+  }
+}
+
+// Return true if the compiled projection of the estimator 'that' is
+// up to date with its projection parameters, false else
+bool PTPEIsCompiled(const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  if (!(that->_proj._isValid))
+    return false;
+  for (int iParam = PTPE_NBPARAM; iParam--;)
+    if (that->_proj._param[iParam] != VecGet(that->_param, iParam))
+      return false;
+  return true;
+}
+
+// Set the projection parameters of the estimator 'that' to 'param'
+// and compile the projection
+void PTPESetParam(PixelToPosEstimator* const that,
+  const VecFloat* const param) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (VecGetDim(param) != PTPE_NBPARAM) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'param' 's dimension is invalid (%d==%d)",
+      VecGetDim(param), PTPE_NBPARAM);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  VecCopy(that->_param, param);
+  PTPECompile(that);
+}
+
+// Load the projection parameters of the estimator 'that' from the
+// 'stream' and compile the projection
+// Return true if the parameters could be loaded, false else
+bool PTPELoadParam(PixelToPosEstimator* const that, FILE* const stream) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (stream == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'stream' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  if (!VecLoad(&(that->_param), stream) ||
+    VecGetDim(that->_param) != PTPE_NBPARAM)
+    return false;
+  PTPECompile(that);
+  return true;
+}
+
+// Convert the screen positions of index 'from' to 'nb' - 1 with the
+// scalar code
+static void PTPEGetPxToMeterBatchScalar(const PTPEProj* const proj,
+  const long from, const long nb, const float* const pxX,
+  const float* const pxY, float* const meterX, float* const meterZ) {
+  for (long iPos = from; iPos < nb; ++iPos)
+    PTPEProjGetAngleToMeter(proj,
+      proj->_kx * pxX[iPos] + proj->_ox,
+      proj->_ky * pxY[iPos] + proj->_oy,
+      meterX + iPos, meterZ + iPos);
+}
+
+#if defined(PTPE_SIMD_WIDTH)
+// Calculate the sine and cosine of the angles 'x'
+static void PTPEVecSinCos(const PTPEVec x, PTPEVec* const s,
+  PTPEVec* const c) {
+  // Reduce the angle to [-pi, pi] (2pi is split in a high and low
+  // part to keep the precision)
+  PTPEVec k = PTPEVecRound(PTPEVecMul(x, PTPEVecSet1(1.0 / PBMATH_TWOPI)));
+  PTPEVec r = PTPEVecSub(x, PTPEVecMul(k, PTPEVecSet1(6.28125)));
+  r = PTPEVecSub(r, PTPEVecMul(k, PTPEVecSet1(1.9353071795864769e-3)));
+  // Reduce the angle to [-pi/2, pi/2] using
+  // sin(pi - r) = sin(r), cos(pi - r) = -cos(r)
+  PTPEVec pi = PTPEVecSet1(PBMATH_PI);
+  PTPEVec halfPi = PTPEVecSet1(PBMATH_HALFPI);
+  PTPEVec maskHi = PTPEVecGt(r, halfPi);
+  PTPEVec maskLo = PTPEVecLt(r, PTPEVecSub(PTPEVecSet1(0.0), halfPi));
+  r = PTPEVecBlend(r, PTPEVecSub(pi, r), maskHi);
+  r = PTPEVecBlend(r,
+    PTPEVecSub(PTPEVecSet1(-PBMATH_PI), r), maskLo);
+  PTPEVec signCos = PTPEVecBlend(PTPEVecSet1(1.0), PTPEVecSet1(-1.0),
+    PTPEVecOr(maskHi, maskLo));
+  // Taylor series, absolute error below 1e-7 on [-pi/2, pi/2]
+  PTPEVec r2 = PTPEVecMul(r, r);
+  PTPEVec ps = PTPEVecSet1(-2.5052108385e-8);
+  ps = PTPEVecMadd(ps, r2, PTPEVecSet1(2.7557319224e-6));
+  ps = PTPEVecMadd(ps, r2, PTPEVecSet1(-1.9841269841e-4));
+  ps = PTPEVecMadd(ps, r2, PTPEVecSet1(8.3333333333e-3));
+  ps = PTPEVecMadd(ps, r2, PTPEVecSet1(-1.6666666667e-1));
+  ps = PTPEVecMadd(ps, r2, PTPEVecSet1(1.0));
+  *s = PTPEVecMul(ps, r);
+  PTPEVec pc = PTPEVecSet1(2.0876756988e-9);
+  pc = PTPEVecMadd(pc, r2, PTPEVecSet1(-2.7557319224e-7));
+  pc = PTPEVecMadd(pc, r2, PTPEVecSet1(2.4801587302e-5));
+  pc = PTPEVecMadd(pc, r2, PTPEVecSet1(-1.3888888889e-3));
+  pc = PTPEVecMadd(pc, r2, PTPEVecSet1(4.1666666667e-2));
+  pc = PTPEVecMadd(pc, r2, PTPEVecSet1(-0.5));
+  pc = PTPEVecMadd(pc, r2, PTPEVecSet1(1.0));
+  *c = PTPEVecMul(pc, signCos);
+}
+#endif
+
+// Convert the 'nb' screen positions ('pxX[i]', 'pxY[i]') to real
+// positions ('meterX[i]', 'meterZ[i]') on the ground plane (y = 0)
+// The arrays are not required to be aligned and must not overlap
+// Uses AVX (8 points per instruction) or SSE2 (4 points per
+// instruction) if enabled at compilation (cf SIMD_ARG in the Makefile),
+// else a scalar loop
+// Results are equal to those of PTPEGetPxToMeter within a relative
+// error of 1e-4 of the distance from the camera
+void PTPEGetPxToMeterBatch(const PixelToPosEstimator* const that,
+  const long nb, const float* const pxX, const float* const pxY,
+  float* const meterX, float* const meterZ) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Get the compiled projection
+  PTPEProj buffer;
+  unsigned int epoch = 0;
+  const PTPEProj* proj = PTPEGetProj(that, &buffer, &epoch);
+  // Convert the positions
+  PTPEProjGetPxToMeterBatch(proj, nb, pxX, pxY, meterX, meterZ);
+  PTPEReleaseProj(that, epoch);
+}
+
+// Same as PTPEGetPxToMeterBatch with the compiled projection 'that'
+void PTPEProjGetPxToMeterBatch(const PTPEProj* const that,
+  const long nb, const float* const pxX, const float* const pxY,
+  float* const meterX, float* const meterZ) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (nb < 0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, "'nb' is invalid (%ld>=0)",
+      nb);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (pxX == NULL || pxY == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'pxX' or 'pxY' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (meterX == NULL || meterZ == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'meterX' or 'meterZ' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  const PTPEProj* proj = that;
+  // Index of the first position processed by the scalar code
+  long from = 0;
+#if defined(PTPE_SIMD_WIDTH)
+  // Broadcast the compiled projection
+  PTPEVec c[3], d[3], a[3], b[3], f[3];
+  for (int i = 3; i--;) {
+    c[i] = PTPEVecSet1(proj->_c[i]);
+    d[i] = PTPEVecSet1(proj->_d[i]);
+    a[i] = PTPEVecSet1(proj->_a[i]);
+    b[i] = PTPEVecSet1(proj->_b[i]);
+    f[i] = PTPEVecSet1(proj->_f[i]);
+  }
+  PTPEVec kx = PTPEVecSet1(proj->_kx);
+  PTPEVec ox = PTPEVecSet1(proj->_ox);
+  PTPEVec ky = PTPEVecSet1(proj->_ky);
+  PTPEVec oy = PTPEVecSet1(proj->_oy);
+  PTPEVec one = PTPEVecSet1(1.0);
+  // Loop on packs of positions
+  from = nb - nb % PTPE_SIMD_WIDTH;
+  for (long iPos = 0; iPos < from; iPos += PTPE_SIMD_WIDTH) {
+    // Rotation angles
+    PTPEVec thetaX = PTPEVecMadd(kx, PTPEVecLoad(pxX + iPos), ox);
+    PTPEVec thetaY = PTPEVecMadd(ky, PTPEVecLoad(pxY + iPos), oy);
+    PTPEVec s1, c1, s2, c2;
+    PTPEVecSinCos(thetaX, &s1, &c1);
+    PTPEVecSinCos(thetaY, &s2, &c2);
+    c1 = PTPEVecSub(c1, one);
+    // Vector from the camera to the point
+    PTPEVec v[3];
+    for (int i = 3; i--;) {
+      v[i] = PTPEVecMul(f[i], c1);
+      v[i] = PTPEVecMadd(d[i], c2, v[i]);
+      v[i] = PTPEVecMadd(a[i], s1, v[i]);
+      v[i] = PTPEVecMadd(b[i], s2, v[i]);
+    }
+    // Projection to ground plane
+    PTPEVec k = PTPEVecDiv(c[1], v[1]);
+    PTPEVecStore(meterX + iPos, PTPEVecSub(c[0], PTPEVecMul(k, v[0])));
+    PTPEVecStore(meterZ + iPos, PTPEVecSub(c[2], PTPEVecMul(k, v[2])));
+  }
+#endif
+  // Process the remaining positions
+  PTPEGetPxToMeterBatchScalar(proj, from, nb, pxX, pxY,
+    meterX, meterZ);
+}
+
+#if defined(PTPE_SIMD_WIDTH)
+// Approximate the arctangent of 'x', absolute error below 5e-3, used
+// as initial guess of Newton iterations
+static PTPEVec PTPEVecAtanApprox(const PTPEVec x) {
+  PTPEVec one = PTPEVecSet1(1.0);
+  PTPEVec k = PTPEVecSet1(0.28125);
+  PTPEVec x2 = PTPEVecMul(x, x);
+  // atan(x) ~= x / (1 + k * x^2) if |x| <= 1
+  PTPEVec lo = PTPEVecDiv(x, PTPEVecMadd(k, x2, one));
+  // atan(x) ~= sign(x) * pi / 2 - x / (x^2 + k) if |x| > 1
+  PTPEVec halfPi = PTPEVecBlend(PTPEVecSet1(-PBMATH_HALFPI),
+    PTPEVecSet1(PBMATH_HALFPI), PTPEVecGt(x, PTPEVecSet1(0.0)));
+  PTPEVec hi = PTPEVecSub(halfPi, PTPEVecDiv(x, PTPEVecAdd(x2, k)));
+  return PTPEVecBlend(lo, hi, PTPEVecGt(x2, one));
+}
+#endif
+
+// Build the inverse 'inv' of the compiled projection 'proj'
+static void PTPEProjInvCompile(PTPEProjInv* const inv,
+  const PTPEProj* const proj) {
+  float normA = sqrt(fastpow(proj->_a[0], 2) +
+    fastpow(proj->_a[1], 2) + fastpow(proj->_a[2], 2));
+  inv->_ar = normA;
+  inv->_fd = 0.0;
+  inv->_fe = 0.0;
+  for (int i = 3; i--;) {
+    inv->_r[i] = proj->_a[i] / normA;
+    inv->_d[i] = proj->_d[i];
+    inv->_e[i] = proj->_b[i];
+    inv->_fd += proj->_f[i] * proj->_d[i];
+    inv->_fe += proj->_f[i] * proj->_b[i];
+  }
+  inv->_ikx = 1.0 / proj->_kx;
+  inv->_iky = 1.0 / proj->_ky;
+}
+
+// Convert the real position ('x', 0.0, 'z') to the screen position
+// ('pxX', 'pxY') with the compiled projection 'proj' and its inverse
+// 'inv'
+// Return false if the position is behind the camera or beyond the
+// horizon, true else
+static bool PTPEProjGetMeterToPx(const PTPEProj* const proj,
+  const PTPEProjInv* const inv, const float x, const float z,
+  float* const pxX, float* const pxY) {
+  *pxX = NAN;
+  *pxY = NAN;
+  // Vector from the camera to the point in the basis of the inverse,
+  // scaled to a unit component along d
+  float w[3] = {x - proj->_c[0], -1.0 * proj->_c[1], z - proj->_c[2]};
+  float wd = w[0] * inv->_d[0] + w[1] * inv->_d[1] + w[2] * inv->_d[2];
+  if (!(proj->_c[1] > 0.0) || !(wd > 0.0))
+    return false;
+  float wr =
+    (w[0] * inv->_r[0] + w[1] * inv->_r[1] + w[2] * inv->_r[2]) / wd;
+  float we =
+    (w[0] * inv->_e[0] + w[1] * inv->_e[1] + w[2] * inv->_e[2]) / wd;
+  // Solve V(thetaX, thetaY) colinear to w, starting from the solution
+  // without the terms in F
+  float thetaX = atan(wr / inv->_ar);
+  float thetaY = atan(we);
+  float g1 = 0.0;
+  float g2 = 0.0;
+  float vd = 0.0;
+  for (int iIter = 0; iIter < PTPE_METERTOPX_NBITER; ++iIter) {
+    float c1 = cos(thetaX);
+    float s1 = sin(thetaX);
+    float c2 = cos(thetaY);
+    float s2 = sin(thetaY);
+    vd = inv->_fd * (c1 - 1.0) + c2;
+    g1 = inv->_ar * s1 - wr * vd;
+    g2 = inv->_fe * (c1 - 1.0) + s2 - we * vd;
+    float j11 = inv->_ar * c1 + wr * inv->_fd * s1;
+    float j12 = wr * s2;
+    float j21 = (we * inv->_fd - inv->_fe) * s1;
+    float j22 = c2 + we * s2;
+    float det = j11 * j22 - j12 * j21;
+    thetaX -= (g1 * j22 - g2 * j12) / det;
+    thetaY -= (g2 * j11 - g1 * j21) / det;
+  }
+  // Check the convergence and that V is in the direction of w and
+  // below the horizon
+  if (!(fabs(g1) < PTPE_METERTOPX_PREC) ||
+    !(fabs(g2) < PTPE_METERTOPX_PREC) || !(vd > 0.0) ||
+    !(fabs(thetaX) < PBMATH_HALFPI) || !(fabs(thetaY) < PBMATH_HALFPI))
+    return false;
+  *pxX = (thetaX - proj->_ox) * inv->_ikx;
+  *pxY = (thetaY - proj->_oy) * inv->_iky;
+  return true;
+}
+
+// Convert the real positions of index 'from' to 'nb' - 1 with the
+// scalar code
+static void PTPEGetMeterToPxBatchScalar(const PTPEProj* const proj,
+  const PTPEProjInv* const inv, const long from, const long nb,
+  const float* const meterX, const float* const meterZ,
+  float* const pxX, float* const pxY, bool* const isValid) {
+  for (long iPos = from; iPos < nb; ++iPos)
+    isValid[iPos] = PTPEProjGetMeterToPx(proj, inv,
+      meterX[iPos], meterZ[iPos], pxX + iPos, pxY + iPos);
+}
+
+// Convert the real position 'realPos' on the ground plane to the
+// screen position 'screenPos', inverse of PTPEGetPxToMeter
+// The screen position may be outside the image
+// Return false if the real position is behind the camera or beyond
+// the horizon of the projection ('screenPos' is then set to NaN), true
+// else
+bool PTPEGetMeterToPx(const PixelToPosEstimator* const that,
+  const VecFloat3D* const realPos, VecFloat2D* const screenPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (realPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'realPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (screenPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'screenPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Get the compiled projection and its inverse
+  PTPEProj buffer;
+  unsigned int epoch = 0;
+  const PTPEProj* proj = PTPEGetProj(that, &buffer, &epoch);
+  PTPEProjInv inv;
+  PTPEProjInvCompile(&inv, proj);
+  // Calculate the screen coordinates
+  bool ret = PTPEProjGetMeterToPx(proj, &inv, VecGet(realPos, 0),
+    VecGet(realPos, 2), screenPos->_val, screenPos->_val + 1);
+  PTPEReleaseProj(that, epoch);
+  return ret;
+}
+
+// Convert the 'nb' real positions ('meterX[i]', 0.0, 'meterZ[i]') to
+// screen positions ('pxX[i]', 'pxY[i]'), inverse of
+// PTPEGetPxToMeterBatch
+// 'isValid[i]' is set to false if the real position is behind the
+// camera or beyond the horizon of the projection (the screen position
+// is then set to NaN), true else
+// The arrays are not required to be aligned and must not overlap
+// Uses AVX or SSE2 if enabled at compilation, else a scalar loop
+void PTPEGetMeterToPxBatch(const PixelToPosEstimator* const that,
+  const long nb, const float* const meterX, const float* const meterZ,
+  float* const pxX, float* const pxY, bool* const isValid) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Get the compiled projection
+  PTPEProj buffer;
+  unsigned int epoch = 0;
+  const PTPEProj* proj = PTPEGetProj(that, &buffer, &epoch);
+  // Convert the positions
+  PTPEProjGetMeterToPxBatch(proj, nb, meterX, meterZ, pxX, pxY,
+    isValid);
+  PTPEReleaseProj(that, epoch);
+}
+
+// Same as PTPEGetMeterToPxBatch with the compiled projection 'that'
+void PTPEProjGetMeterToPxBatch(const PTPEProj* const that,
+  const long nb, const float* const meterX, const float* const meterZ,
+  float* const pxX, float* const pxY, bool* const isValid) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (nb < 0) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, "'nb' is invalid (%ld>=0)",
+      nb);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (meterX == NULL || meterZ == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg,
+      "'meterX' or 'meterZ' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (pxX == NULL || pxY == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'pxX' or 'pxY' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (isValid == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'isValid' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  const PTPEProj* proj = that;
+  PTPEProjInv inv;
+  PTPEProjInvCompile(&inv, proj);
+  // Index of the first position processed by the scalar code
+  long from = 0;
+#if defined(PTPE_SIMD_WIDTH)
+  // Broadcast the compiled projection and its inverse
+  PTPEVec r[3], d[3], e[3];
+  for (int i = 3; i--;) {
+    r[i] = PTPEVecSet1(inv._r[i]);
+    d[i] = PTPEVecSet1(inv._d[i]);
+    e[i] = PTPEVecSet1(inv._e[i]);
+  }
+  PTPEVec cx = PTPEVecSet1(proj->_c[0]);
+  PTPEVec cy = PTPEVecSet1(-1.0 * proj->_c[1]);
+  PTPEVec cz = PTPEVecSet1(proj->_c[2]);
+  PTPEVec ar = PTPEVecSet1(inv._ar);
+  PTPEVec fd = PTPEVecSet1(inv._fd);
+  PTPEVec fe = PTPEVecSet1(inv._fe);
+  PTPEVec ox = PTPEVecSet1(proj->_ox);
+  PTPEVec oy = PTPEVecSet1(proj->_oy);
+  PTPEVec ikx = PTPEVecSet1(inv._ikx);
+  PTPEVec iky = PTPEVecSet1(inv._iky);
+  PTPEVec zero = PTPEVecSet1(0.0);
+  PTPEVec one = PTPEVecSet1(1.0);
+  PTPEVec prec = PTPEVecSet1(PTPE_METERTOPX_PREC);
+  PTPEVec halfPi = PTPEVecSet1(PBMATH_HALFPI);
+  PTPEVec nan = PTPEVecSet1(NAN);
+  bool isAbove = (proj->_c[1] > 0.0);
+  // Loop on packs of positions
+  from = nb - nb % PTPE_SIMD_WIDTH;
+  for (long iPos = 0; iPos < from; iPos += PTPE_SIMD_WIDTH) {
+    // Vector from the camera to the point in the basis of the inverse,
+    // scaled to a unit component along d
+    PTPEVec wx = PTPEVecSub(PTPEVecLoad(meterX + iPos), cx);
+    PTPEVec wz = PTPEVecSub(PTPEVecLoad(meterZ + iPos), cz);
+    PTPEVec wd = PTPEVecMadd(d[0], wx,
+      PTPEVecMadd(d[1], cy, PTPEVecMul(d[2], wz)));
+    PTPEVec wr = PTPEVecDiv(PTPEVecMadd(r[0], wx,
+      PTPEVecMadd(r[1], cy, PTPEVecMul(r[2], wz))), wd);
+    PTPEVec we = PTPEVecDiv(PTPEVecMadd(e[0], wx,
+      PTPEVecMadd(e[1], cy, PTPEVecMul(e[2], wz))), wd);
+    // Newton iterations
+    PTPEVec thetaX = PTPEVecAtanApprox(PTPEVecDiv(wr, ar));
+    PTPEVec thetaY = PTPEVecAtanApprox(we);
+    PTPEVec g1 = zero;
+    PTPEVec g2 = zero;
+    PTPEVec vd = zero;
+    for (int iIter = 0; iIter < PTPE_METERTOPX_NBITER; ++iIter) {
+      PTPEVec s1, c1, s2, c2;
+      PTPEVecSinCos(thetaX, &s1, &c1);
+      PTPEVecSinCos(thetaY, &s2, &c2);
+      PTPEVec c1m = PTPEVecSub(c1, one);
+      vd = PTPEVecMadd(fd, c1m, c2);
+      g1 = PTPEVecSub(PTPEVecMul(ar, s1), PTPEVecMul(wr, vd));
+      g2 = PTPEVecSub(PTPEVecMadd(fe, c1m, s2), PTPEVecMul(we, vd));
+      PTPEVec j11 = PTPEVecMadd(ar, c1, PTPEVecMul(PTPEVecMul(wr, fd), s1));
+      PTPEVec j12 = PTPEVecMul(wr, s2);
+      PTPEVec j21 =
+        PTPEVecMul(PTPEVecSub(PTPEVecMul(we, fd), fe), s1);
+      PTPEVec j22 = PTPEVecMadd(we, s2, c2);
+      PTPEVec det =
+        PTPEVecSub(PTPEVecMul(j11, j22), PTPEVecMul(j12, j21));
+      thetaX = PTPEVecSub(thetaX, PTPEVecDiv(
+        PTPEVecSub(PTPEVecMul(g1, j22), PTPEVecMul(g2, j12)), det));
+      thetaY = PTPEVecSub(thetaY, PTPEVecDiv(
+        PTPEVecSub(PTPEVecMul(g2, j11), PTPEVecMul(g1, j21)), det));
+    }
+    // Check the convergence and that V is in the direction of w and
+    // below the horizon (comparisons with NaN are false)
+    PTPEVec mask = PTPEVecAnd(PTPEVecGt(wd, zero), PTPEVecGt(vd, zero));
+    mask = PTPEVecAnd(mask, PTPEVecAnd(PTPEVecLt(g1, prec),
+      PTPEVecGt(g1, PTPEVecSub(zero, prec))));
+    mask = PTPEVecAnd(mask, PTPEVecAnd(PTPEVecLt(g2, prec),
+      PTPEVecGt(g2, PTPEVecSub(zero, prec))));
+    mask = PTPEVecAnd(mask, PTPEVecAnd(PTPEVecLt(thetaX, halfPi),
+      PTPEVecGt(thetaX, PTPEVecSub(zero, halfPi))));
+    mask = PTPEVecAnd(mask, PTPEVecAnd(PTPEVecLt(thetaY, halfPi),
+      PTPEVecGt(thetaY, PTPEVecSub(zero, halfPi))));
+    PTPEVecStore(pxX + iPos, PTPEVecBlend(nan,
+      PTPEVecMul(PTPEVecSub(thetaX, ox), ikx), mask));
+    PTPEVecStore(pxY + iPos, PTPEVecBlend(nan,
+      PTPEVecMul(PTPEVecSub(thetaY, oy), iky), mask));
+    int bits = PTPEVecMoveMask(mask);
+    for (int i = 0; i < PTPE_SIMD_WIDTH; ++i)
+      isValid[iPos + i] = (isAbove && ((bits >> i) & 1));
+  }
+  if (!isAbove)
+    for (long iPos = 0; iPos < from; ++iPos) {
+      pxX[iPos] = NAN;
+      pxY[iPos] = NAN;
+    }
+#endif
+  // Process the remaining positions
+  PTPEGetMeterToPxBatchScalar(proj, &inv, from, nb, meterX, meterZ,
+    pxX, pxY, isValid);
+}
+
+// Create the lookup table of the real position of every pixel of the
+// image for the estimator 'that'
+PTPELut* PTPELutCreate(const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Allocate memory
+  PTPELut* lut = PBErrMalloc(PixelToPosEstimatorErr, sizeof(PTPELut));
+  lut->_nbNodeX = (long)VecGet(&(that->_imgSize), 0) + 1;
+  lut->_nbNodeY = (long)VecGet(&(that->_imgSize), 1) + 1;
+  lut->_size = sizeof(PTPELutHeader) +
+    sizeof(float) * 2 * lut->_nbNodeX * lut->_nbNodeY;
+  lut->_data = PBErrMalloc(PixelToPosEstimatorErr, lut->_size);
+  lut->_isMapped = false;
+  // Set the header
+  PTPELutHeader* header = lut->_data;
+  memset(header, 0, sizeof(PTPELutHeader));
+  strcpy(header->_magic, PTPE_LUT_MAGIC);
+  header->_version = PTPE_LUT_VERSION;
+  header->_nbNodeX = lut->_nbNodeX;
+  header->_nbNodeY = lut->_nbNodeY;
+  for (int i = 3; i--;)
+    header->_cameraPos[i] = VecGet(&(that->_cameraPos), i);
+  for (int i = 2; i--;)
+    header->_imgSize[i] = VecGet(&(that->_imgSize), i);
+  for (int iParam = PTPE_NBPARAM; iParam--;)
+    header->_param[iParam] = VecGet(that->_param, iParam);
+  // Calculate the nodes
+  float* meter = (float*)(header + 1);
+  PTPELutFill(that, lut->_nbNodeX, lut->_nbNodeY, meter);
+  lut->_meter = meter;
+  // Return the new table
+  return lut;
+}
+
+// Calculate the real positions (x, z) of the 'nbNodeX' x 'nbNodeY'
+// nodes of the lookup table of the estimator 'that' into 'meter', row
+// by row
+static void PTPELutFill(const PixelToPosEstimator* const that,
+  const long nbNodeX, const long nbNodeY, float* const meter) {
+  float* pxX = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(float) * 4 * nbNodeX);
+  float* pxY = pxX + nbNodeX;
+  float* meterX = pxY + nbNodeX;
+  float* meterZ = meterX + nbNodeX;
+  for (long i = nbNodeX; i--;)
+    pxX[i] = (float)i;
+  for (long j = 0; j < nbNodeY; ++j) {
+    for (long i = nbNodeX; i--;)
+      pxY[i] = (float)j;
+    PTPEGetPxToMeterBatch(that, nbNodeX, pxX, pxY, meterX, meterZ);
+    float* row = meter + 2 * j * nbNodeX;
+    for (long i = nbNodeX; i--;) {
+      row[2 * i] = meterX[i];
+      row[2 * i + 1] = meterZ[i];
+    }
+  }
+  free(pxX);
+}
+
+// Free memory used by the lookup table 'that'
+void PTPELutFree(PTPELut** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  if ((*that)->_isMapped)
+    munmap((*that)->_data, (*that)->_size);
+  else
+    free((*that)->_data);
+  free(*that);
+  *that = NULL;
+}
+
+// Save the lookup table 'that' into the binary file at 'path'
+// Return true if the table could be saved, false else
+bool PTPELutSave(const PTPELut* const that, const char* const path) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (path == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'path' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  FILE* stream = fopen(path, "wb");
+  if (stream == NULL)
+    return false;
+  bool ret = (fwrite(that->_data, 1, that->_size, stream) == that->_size);
+  if (fclose(stream) != 0)
+    ret = false;
+  return ret;
+}
+
+// Memory map the lookup table saved at 'path'
+// Return NULL if the file can't be mapped, or if it hasn't been
+// created from the same camera position, image dimensions and
+// projection parameters as the estimator 'that'
+PTPELut* PTPELutLoad(const PixelToPosEstimator* const that,
+  const char* const path) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (path == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'path' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Map the file
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || 
+    (size_t)st.st_size < sizeof(PTPELutHeader)) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = st.st_size;
+  void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return NULL;
+  // Check the header
+  const PTPELutHeader* header = data;
+  bool isValid = 
+    (strncmp(header->_magic, PTPE_LUT_MAGIC, 8) == 0) &&
+    header->_version == PTPE_LUT_VERSION &&
+    header->_nbNodeX == (uint32_t)VecGet(&(that->_imgSize), 0) + 1 &&
+    header->_nbNodeY == (uint32_t)VecGet(&(that->_imgSize), 1) + 1 &&
+    size == sizeof(PTPELutHeader) + 
+      sizeof(float) * 2 * header->_nbNodeX * header->_nbNodeY;
+  for (int i = 3; isValid && i--;)
+    isValid = (header->_cameraPos[i] == VecGet(&(that->_cameraPos), i));
+  for (int i = 2; isValid && i--;)
+    isValid = (header->_imgSize[i] == VecGet(&(that->_imgSize), i));
+  for (int iParam = PTPE_NBPARAM; isValid && iParam--;)
+    isValid = (header->_param[iParam] == VecGet(that->_param, iParam));
+  if (!isValid) {
+    munmap(data, size);
+    return NULL;
+  }
+  // Create the table
+  PTPELut* lut = PBErrMalloc(PixelToPosEstimatorErr, sizeof(PTPELut));
+  lut->_nbNodeX = header->_nbNodeX;
+  lut->_nbNodeY = header->_nbNodeY;
+  lut->_meter = (const float*)(header + 1);
+  lut->_data = data;
+  lut->_size = size;
+  lut->_isMapped = true;
+  // Return the table
+  return lut;
+}
+
+// Convert the screen position to a real position using the lookup
+// table 'that', with bilinear interpolation between the pixels
+// Screen positions outside the image are clamped to the image
+VecFloat3D PTPELutGetPxToMeter(const PTPELut* const that,
+  const VecFloat2D* const screenPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (screenPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'screenPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Declare a variable to memorize the result
+  VecFloat3D res = VecFloatCreateStatic3D();
+  // Get the cell containing the position and the position inside
+  // the cell
+  float x = VecGet(screenPos, 0);
+  float y = VecGet(screenPos, 1);
+  x = (x < 0.0 ? 0.0 : (x > that->_nbNodeX - 1 ? that->_nbNodeX - 1 : x));
+  y = (y < 0.0 ? 0.0 : (y > that->_nbNodeY - 1 ? that->_nbNodeY - 1 : y));
+  long i = (long)x;
+  long j = (long)y;
+  if (i > that->_nbNodeX - 2)
+    i = that->_nbNodeX - 2;
+  if (j > that->_nbNodeY - 2)
+    j = that->_nbNodeY - 2;
+  float fx = x - (float)i;
+  float fy = y - (float)j;
+  // Bilinear interpolation
+  const float* n00 = that->_meter + 2 * (j * that->_nbNodeX + i);
+  const float* n01 = n00 + 2 * that->_nbNodeX;
+  for (int k = 2; k--;) {
+    float top = n00[k] + fx * (n00[2 + k] - n00[k]);
+    float bottom = n01[k] + fx * (n01[2 + k] - n01[k]);
+    VecSet(&res, 2 * k, top + fy * (bottom - top));
+  }
+  // Return the result
+  return res;
+}
+
+// Set the number of threads used by PTPEInit to evaluate the
+// population of the estimator 'that' to 'nbThread' (1 by default)
+// The calibration gives the same result whatever the number of threads
+void PTPESetNbThread(PixelToPosEstimator* const that,
+  const int nbThread) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (nbThread < 1) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg, 
+      "'nbThread' is invalid (%d>=1)", nbThread);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  that->_nbThread = nbThread;
+}
+
+// Get the number of threads used by PTPEInit to evaluate the
+// population of the estimator 'that'
+int PTPEGetNbThread(const PixelToPosEstimator* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  return that->_nbThread;
+}
+
+// Create a pool of 'nbThread' threads (including the calling thread)
+static PTPEPool* PTPEPoolCreate(const int nbThread) {
+  // Allocate memory
+  PTPEPool* pool = PBErrMalloc(PixelToPosEstimatorErr, sizeof(PTPEPool));
+  pool->_nbThread = nbThread;
+  pool->_iJob = 0;
+  pool->_nbDone = 0;
+  pool->_quit = false;
+  pool->_job = NULL;
+  pool->_arg = NULL;
+  pthread_mutex_init(&(pool->_mutex), NULL);
+  pthread_cond_init(&(pool->_condStart), NULL);
+  pthread_cond_init(&(pool->_condDone), NULL);
+  pool->_threads = NULL;
+  if (nbThread > 1)
+    pool->_threads = PBErrMalloc(PixelToPosEstimatorErr,
+      sizeof(pthread_t) * (nbThread - 1));
+  // Start the worker threads
+  for (int iThread = 1; iThread < nbThread; ++iThread) {
+    PTPEPoolWorker* worker = PBErrMalloc(PixelToPosEstimatorErr,
+      sizeof(PTPEPoolWorker));
+    worker->_pool = pool;
+    worker->_iThread = iThread;
+    if (pthread_create(pool->_threads + iThread - 1, NULL,
+      PTPEPoolWorkerMain, worker) != 0) {
+      PixelToPosEstimatorErr->_type = PBErrTypeOther;
+      sprintf(PixelToPosEstimatorErr->_msg, 
+        "Can't create the thread #%d", iThread);
+      PBErrCatch(PixelToPosEstimatorErr);
+    }
+  }
+  // Return the new pool
+  return pool;
+}
+
+// Free the pool of threads 'that'
+static void PTPEPoolFree(PTPEPool** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  // Stop the worker threads
+  pthread_mutex_lock(&((*that)->_mutex));
+  (*that)->_quit = true;
+  pthread_cond_broadcast(&((*that)->_condStart));
+  pthread_mutex_unlock(&((*that)->_mutex));
+  for (int iThread = 1; iThread < (*that)->_nbThread; ++iThread)
+    pthread_join((*that)->_threads[iThread - 1], NULL);
+  // Free memory
+  pthread_mutex_destroy(&((*that)->_mutex));
+  pthread_cond_destroy(&((*that)->_condStart));
+  pthread_cond_destroy(&((*that)->_condDone));
+  free((*that)->_threads);
+  free(*that);
+  *that = NULL;
+}
+
+// Execute the 'job' with its argument 'arg' on all the threads of the
+// pool 'that' and wait for its completion
+static void PTPEPoolRun(PTPEPool* const that, 
+  void (*job)(void* const arg, const int iThread, const int nbThread),
+  void* const arg) {
+  // If there is only one thread, run the job directly
+  if (that->_nbThread == 1) {
+    job(arg, 0, 1);
+    return;
+  }
+  // Start the job on the worker threads
+  pthread_mutex_lock(&(that->_mutex));
+  that->_job = job;
+  that->_arg = arg;
+  that->_nbDone = 0;
+  ++(that->_iJob);
+  pthread_cond_broadcast(&(that->_condStart));
+  pthread_mutex_unlock(&(that->_mutex));
+  // Run the job on the calling thread
+  job(arg, 0, that->_nbThread);
+  // Wait for the worker threads
+  pthread_mutex_lock(&(that->_mutex));
+  while (that->_nbDone < that->_nbThread - 1)
+    pthread_cond_wait(&(that->_condDone), &(that->_mutex));
+  pthread_mutex_unlock(&(that->_mutex));
+}
+
+// Main function of the worker threads of a PTPEPool
+static void* PTPEPoolWorkerMain(void* arg) {
+  PTPEPoolWorker* worker = arg;
+  PTPEPool* pool = worker->_pool;
+  int iThread = worker->_iThread;
+  free(worker);
+  unsigned long iJob = 0;
+  pthread_mutex_lock(&(pool->_mutex));
+  while (true) {
+    // Wait for a new job
+    while (!(pool->_quit) && pool->_iJob == iJob)
+      pthread_cond_wait(&(pool->_condStart), &(pool->_mutex));
+    if (pool->_quit)
+      break;
+    iJob = pool->_iJob;
+    pthread_mutex_unlock(&(pool->_mutex));
+    // Run the job
+    pool->_job(pool->_arg, iThread, pool->_nbThread);
+    // Signal the completion of the job
+    pthread_mutex_lock(&(pool->_mutex));
+    ++(pool->_nbDone);
+    if (pool->_nbDone == pool->_nbThread - 1)
+      pthread_cond_signal(&(pool->_condDone));
+  }
+  pthread_mutex_unlock(&(pool->_mutex));
+  return NULL;
+}
+
+// Evaluation job of PTPEInit, the thread 'iThread' evaluates the adns
+// 'iThread', 'iThread' + 'nbThread', ...
+static void PTPEInitEvalJob(void* const arg, const int iThread,
+  const int nbThread) {
+  PTPEInitEvalArg* evalArg = arg;
+  const PixelToPosEstimator* estimator = evalArg->_estimator;
+  int nbAdn = GAGetNbAdns(evalArg->_gas[0]);
+  // Buffer for the conversion of the adns of the 5 degrees of freedom
+  // model
+  VecFloat* param = NULL;
+  if (evalArg->_model == PTPEModel5DOF)
+    param = VecFloatCreate(PTPE_NBPARAM);
+  for (int iAdn = iThread; iAdn < evalArg->_nbIsland * nbAdn; 
+    iAdn += nbThread) {
+    if (evalArg->_isKnown[iAdn])
+      continue;
+    int iIsland = iAdn / nbAdn;
+    const VecFloat* adn = 
+      GAAdnAdnF(GAAdn(evalArg->_gas[iIsland], iAdn % nbAdn));
+    if (param != NULL) {
+      PTPEParam5DOFToParam(estimator, adn, param);
+      adn = param;
+    }
+    evalArg->_evals[iAdn] = PTPEEvaluateParamDatasetBounded(
+      estimator, adn, evalArg->_dataset, evalArg->_cutoffs[iIsland],
+      evalArg->_isRejected + iAdn);
+  }
+  if (param != NULL)
+    VecFree(&param);
+}
+
+// Operations on PTPEDual
+static PTPEDual PTPEDualAdd(const PTPEDual a, const PTPEDual b) {
+  PTPEDual res;
+  res._v = a._v + b._v;
+  for (int i = PTPE_NBPARAM; i--;)
+    res._d[i] = a._d[i] + b._d[i];
+  return res;
+}
+static PTPEDual PTPEDualSub(const PTPEDual a, const PTPEDual b) {
+  PTPEDual res;
+  res._v = a._v - b._v;
+  for (int i = PTPE_NBPARAM; i--;)
+    res._d[i] = a._d[i] - b._d[i];
+  return res;
+}
+static PTPEDual PTPEDualMul(const PTPEDual a, const PTPEDual b) {
+  PTPEDual res;
+  res._v = a._v * b._v;
+  for (int i = PTPE_NBPARAM; i--;)
+    res._d[i] = a._d[i] * b._v + a._v * b._d[i];
+  return res;
+}
+static PTPEDual PTPEDualDiv(const PTPEDual a, const PTPEDual b) {
+  PTPEDual res;
+  res._v = a._v / b._v;
+  for (int i = PTPE_NBPARAM; i--;)
+    res._d[i] = (a._d[i] - res._v * b._d[i]) / b._v;
+  return res;
+}
+static PTPEDual PTPEDualSqrt(const PTPEDual a) {
+  PTPEDual res;
+  res._v = sqrt(a._v);
+  for (int i = PTPE_NBPARAM; i--;)
+    res._d[i] = 0.5 * a._d[i] / res._v;
+  return res;
+}
+
+// Normalise the vector 'v'
+static void PTPEDualNormalise(PTPEDual v[3]) {
+  PTPEDual norm = PTPEDualSqrt(PTPEDualAdd(PTPEDualAdd(
+    PTPEDualMul(v[0], v[0]), PTPEDualMul(v[1], v[1])),
+    PTPEDualMul(v[2], v[2])));
+  for (int i = 3; i--;)
+    v[i] = PTPEDualDiv(v[i], norm);
+}
+
+// Calculate the cross product 'res' = 'a' x 'b'
+static void PTPEDualCrossProd(const PTPEDual a[3], const PTPEDual b[3],
+  PTPEDual res[3]) {
+  res[0] = PTPEDualSub(PTPEDualMul(a[1], b[2]), PTPEDualMul(a[2], b[1]));
+  res[1] = PTPEDualSub(PTPEDualMul(a[2], b[0]), PTPEDualMul(a[0], b[2]));
+  res[2] = PTPEDualSub(PTPEDualMul(a[0], b[1]), PTPEDualMul(a[1], b[0]));
+}
+
+// Build the compiled projection with derivatives 'proj' from the
+// camera position 'cameraPos', the image dimensions 'imgSize' and the
+// projection parameters 'param' (cf PTPEProjCompile)
+static void PTPEDualProjCompile(PTPEDualProj* const proj,
+  const VecFloat3D* const cameraPos, const VecFloat2D* const imgSize,
+  const double* const param) {
+  // Parameters as variables
+  PTPEDual p[PTPE_NBPARAM];
+  for (int iParam = PTPE_NBPARAM; iParam--;) {
+    p[iParam]._v = param[iParam];
+    for (int i = PTPE_NBPARAM; i--;)
+      p[iParam]._d[i] = (i == iParam ? 1.0 : 0.0);
+  }
+  // Normalized vector Camera->POV
+  PTPEDual CP[3];
+  for (int i = 3; i--;) {
+    CP[i] = p[i];
+    CP[i]._v -= VecGet(cameraPos, i);
+  }
+  PTPEDualNormalise(CP);
+  // Normalized up vector
+  PTPEDual Up[3] = {p[5], p[6], p[7]};
+  PTPEDualNormalise(Up);
+  // Normalized right vector
+  PTPEDual Right[3];
+  PTPEDualCrossProd(CP, Up, Right);
+  PTPEDualNormalise(Right);
+  // Vectors of the decomposition
+  PTPEDualCrossProd(Up, CP, proj->_a);
+  PTPEDualCrossProd(Right, CP, proj->_b);
+  PTPEDual dotUpCP = PTPEDualAdd(PTPEDualAdd(
+    PTPEDualMul(Up[0], CP[0]), PTPEDualMul(Up[1], CP[1])),
+    PTPEDualMul(Up[2], CP[2]));
+  for (int i = 3; i--;) {
+    proj->_d[i] = CP[i];
+    proj->_f[i] = PTPEDualSub(CP[i], PTPEDualMul(Up[i], dotUpCP));
+    proj->_c[i] = VecGet(cameraPos, i);
+  }
+  // Conversion from screen positions to angles
+  proj->_sx = param[3];
+  proj->_sy = param[4];
+  proj->_kx = 2.0 / VecGet(imgSize, 0);
+  proj->_ox = -1.0;
+  proj->_ky = 2.0 / VecGet(imgSize, 1);
+  proj->_oy = -1.0;
+}
+
+// Calculate the real position ('res[0]', 0.0, 'res[1]') of the screen
+// position ('x', 'y') and its jacobian 'jac' relative to the
+// projection parameters with the compiled projection 'proj'
+static void PTPEDualProjGetPxToMeter(const PTPEDualProj* const proj,
+  const float x, const float y, double res[2],
+  double jac[2][PTPE_NBPARAM]) {
+  // Polar position
+  double u = proj->_kx * x + proj->_ox;
+  double v = proj->_ky * y + proj->_oy;
+  // Rotation angles and their sine and cosine, only depending on Sx
+  // and Sy
+  double thetaX = proj->_sx * u;
+  double thetaY = proj->_sy * v;
+  PTPEDual c1 = {cos(thetaX) - 1.0, {0.0}};
+  PTPEDual s1 = {sin(thetaX), {0.0}};
+  PTPEDual c2 = {cos(thetaY), {0.0}};
+  PTPEDual s2 = {sin(thetaY), {0.0}};
+  c1._d[3] = -1.0 * s1._v * u;
+  s1._d[3] = (c1._v + 1.0) * u;
+  c2._d[4] = -1.0 * s2._v * v;
+  s2._d[4] = c2._v * v;
+  // Vector from the camera to the point
+  PTPEDual V[3];
+  for (int i = 3; i--;)
+    V[i] = PTPEDualAdd(
+      PTPEDualAdd(PTPEDualMul(proj->_f[i], c1), 
+      PTPEDualMul(proj->_d[i], c2)),
+      PTPEDualAdd(PTPEDualMul(proj->_a[i], s1), 
+      PTPEDualMul(proj->_b[i], s2)));
+  // Projection to ground plane
+  PTPEDual rx = PTPEDualDiv(V[0], V[1]);
+  PTPEDual rz = PTPEDualDiv(V[2], V[1]);
+  res[0] = proj->_c[0] - proj->_c[1] * rx._v;
+  res[1] = proj->_c[2] - proj->_c[1] * rz._v;
+  for (int iParam = PTPE_NBPARAM; iParam--;) {
+    jac[0][iParam] = -1.0 * proj->_c[1] * rx._d[iParam];
+    jac[1][iParam] = -1.0 * proj->_c[1] * rz._d[iParam];
+  }
+}
+
+// Calculate the sum of squared errors of the data set 'dataset' for
+// the projection parameters 'param', and if 'jtj' and 'jtr' are not
+// null, the matrix J^t.J and vector J^t.r of the residuals r
+static double PTPEGetSSE(const PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const double* const param,
+  double jtj[PTPE_NBPARAM][PTPE_NBPARAM], double jtr[PTPE_NBPARAM]) {
+  PTPEDualProj proj;
+  PTPEDualProjCompile(&proj, &(that->_cameraPos), &(that->_imgSize),
+    param);
+  if (jtj != NULL)
+    for (int i = PTPE_NBPARAM; i--;) {
+      jtr[i] = 0.0;
+      for (int j = PTPE_NBPARAM; j--;)
+        jtj[i][j] = 0.0;
+    }
+  double sse = 0.0;
+  for (long iPos = 0; iPos < dataset->_nb; ++iPos) {
+    double res[2];
+    double jac[2][PTPE_NBPARAM];
+    PTPEDualProjGetPxToMeter(&proj, dataset->_pxX[iPos],
+      dataset->_pxY[iPos], res, jac);
+    double r[2] = {
+      res[0] - dataset->_meterX[iPos],
+      res[1] - dataset->_meterZ[iPos]};
+    sse += r[0] * r[0] + r[1] * r[1];
+    if (jtj != NULL)
+      for (int k = 2; k--;)
+        for (int i = PTPE_NBPARAM; i--;) {
+          jtr[i] += jac[k][i] * r[k];
+          for (int j = PTPE_NBPARAM; j--;)
+            jtj[i][j] += jac[k][i] * jac[k][j];
+        }
+  }
+  // If the estimation is not a number, return an infinite error to
+  // reject these parameters
+  if (isnan(sse))
+    sse = HUGE_VAL;
+  return sse;
+}
+
+// Solve the linear system 'mat'.'x' = 'vec' of dimension PTPE_NBPARAM
+// with Gaussian elimination, 'mat' and 'vec' are modified
+// Return false if the system is singular, true else
+static bool PTPESolve8(double mat[PTPE_NBPARAM][PTPE_NBPARAM],
+  double vec[PTPE_NBPARAM], double x[PTPE_NBPARAM]) {
+  for (int iCol = 0; iCol < PTPE_NBPARAM; ++iCol) {
+    // Search the pivot
+    int iPivot = iCol;
+    for (int iRow = iCol + 1; iRow < PTPE_NBPARAM; ++iRow)
+      if (fabs(mat[iRow][iCol]) > fabs(mat[iPivot][iCol]))
+        iPivot = iRow;
+    if (fabs(mat[iPivot][iCol]) < 1e-300)
+      return false;
+    // Swap the rows
+    if (iPivot != iCol) {
+      for (int j = PTPE_NBPARAM; j--;) {
+        double tmp = mat[iCol][j];
+        mat[iCol][j] = mat[iPivot][j];
+        mat[iPivot][j] = tmp;
+      }
+      double tmp = vec[iCol];
+      vec[iCol] = vec[iPivot];
+      vec[iPivot] = tmp;
+    }
+    // Eliminate
+    for (int iRow = iCol + 1; iRow < PTPE_NBPARAM; ++iRow) {
+      double k = mat[iRow][iCol] / mat[iCol][iCol];
+      for (int j = iCol; j < PTPE_NBPARAM; ++j)
+        mat[iRow][j] -= k * mat[iCol][j];
+      vec[iRow] -= k * vec[iCol];
+    }
+  }
+  // Back substitution
+  for (int i = PTPE_NBPARAM; i--;) {
+    double sum = vec[i];
+    for (int j = i + 1; j < PTPE_NBPARAM; ++j)
+      sum -= mat[i][j] * x[j];
+    x[i] = sum / mat[i][i];
+  }
+  return true;
+}
+
+// Calculate the bounds 'bounds' of the yaw and pitch of the directions
+// from the camera of the estimator 'that' to the bounding box
+// 'POVmin'-'POVmax'
+static void PTPEGet5DOFBounds(const PixelToPosEstimator* const that,
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax,
+  float bounds[2][2]) {
+  float cx = VecGet(&(that->_cameraPos), 0);
+  float cy = VecGet(&(that->_cameraPos), 1);
+  float cz = VecGet(&(that->_cameraPos), 2);
+  float minX = VecGet(POVmin, 0) - cx;
+  float maxX = VecGet(POVmax, 0) - cx;
+  float minZ = VecGet(POVmin, 2) - cz;
+  float maxZ = VecGet(POVmax, 2) - cz;
+  // Shortest and longest horizontal distances to the box
+  float dx = (minX > 0.0 ? minX : (maxX < 0.0 ? -1.0 * maxX : 0.0));
+  float dz = (minZ > 0.0 ? minZ : (maxZ < 0.0 ? -1.0 * maxZ : 0.0));
+  float distMin = sqrt(dx * dx + dz * dz);
+  dx = (fabs(minX) > fabs(maxX) ? minX : maxX);
+  dz = (fabs(minZ) > fabs(maxZ) ? minZ : maxZ);
+  float distMax = sqrt(dx * dx + dz * dz);
+  // Yaw
+  if (distMin < PBMATH_EPSILON) {
+    // The camera is above or below the box, all the yaws are possible
+    bounds[0][0] = -1.0 * PBMATH_PI;
+    bounds[0][1] = PBMATH_PI;
+  } else {
+    // The extrema are reached at the corners of the box, relative
+    // to the direction of the center of the box
+    float yawCenter = atan2(0.5 * (minX + maxX), 0.5 * (minZ + maxZ));
+    bounds[0][0] = yawCenter;
+    bounds[0][1] = yawCenter;
+    for (int iCorner = 4; iCorner--;) {
+      float yaw = atan2((iCorner & 1 ? maxX : minX), 
+        (iCorner & 2 ? maxZ : minZ)) - yawCenter;
+      yaw = atan2(sin(yaw), cos(yaw)) + yawCenter;
+      if (yaw < bounds[0][0])
+        bounds[0][0] = yaw;
+      if (yaw > bounds[0][1])
+        bounds[0][1] = yaw;
+    }
+  }
+  // Pitch
+  float minY = VecGet(POVmin, 1) - cy;
+  float maxY = VecGet(POVmax, 1) - cy;
+  bounds[1][0] = atan2(minY, (minY < 0.0 ? distMin : distMax));
+  bounds[1][1] = atan2(maxY, (maxY > 0.0 ? distMin : distMax));
+  for (int i = 2; i--;) {
+    if (bounds[1][i] < -1.0 * PBMATH_HALFPI + PTPE_PITCH_MARGIN)
+      bounds[1][i] = -1.0 * PBMATH_HALFPI + PTPE_PITCH_MARGIN;
+    if (bounds[1][i] > PBMATH_HALFPI - PTPE_PITCH_MARGIN)
+      bounds[1][i] = PBMATH_HALFPI - PTPE_PITCH_MARGIN;
+  }
+}
+
+// Create a cache of evaluations for at least 'nbAdn' adns of length
+// 'lenAdn'
+static PTPEEvalCache* PTPEEvalCacheCreate(const int lenAdn, 
+  const long nbAdn) {
+  PTPEEvalCache* that = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(PTPEEvalCache));
+  that->_lenAdn = lenAdn;
+  // Keep the load factor below 0.5 to have short probe sequences
+  that->_nbSlot = 1;
+  while (that->_nbSlot < 2 * nbAdn)
+    that->_nbSlot <<= 1;
+  that->_adns = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(float) * that->_nbSlot * lenAdn);
+  that->_evals = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(float) * that->_nbSlot);
+  that->_isUsed = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(bool) * that->_nbSlot);
+  PTPEEvalCacheClear(that);
+  return that;
+}
+
+// Free the cache of evaluations 'that'
+static void PTPEEvalCacheFree(PTPEEvalCache** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  free((*that)->_adns);
+  free((*that)->_evals);
+  free((*that)->_isUsed);
+  free(*that);
+  *that = NULL;
+}
+
+// Empty the cache of evaluations 'that'
+static void PTPEEvalCacheClear(PTPEEvalCache* const that) {
+  memset(that->_isUsed, 0, sizeof(bool) * that->_nbSlot);
+}
+
+// Return the slot of the adn 'adn' in the cache 'that', or the first
+// unused slot where it should be added
+static long PTPEEvalCacheGetSlot(const PTPEEvalCache* const that,
+  const VecFloat* const adn) {
+  // FNV-1a hash of the bits of the adn's values
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < that->_lenAdn; ++i) {
+    float val = VecGet(adn, i);
+    uint32_t bits = 0;
+    memcpy(&bits, &val, sizeof(float));
+    for (int iByte = 0; iByte < 4; ++iByte) {
+      hash ^= (bits >> (8 * iByte)) & 0xFF;
+      hash *= 16777619u;
+    }
+  }
+  // Linear probing until the adn or an unused slot is found
+  long iSlot = hash & (that->_nbSlot - 1);
+  while (that->_isUsed[iSlot]) {
+    const float* slotAdn = that->_adns + iSlot * that->_lenAdn;
+    int i = 0;
+    while (i < that->_lenAdn && slotAdn[i] == VecGet(adn, i))
+      ++i;
+    if (i == that->_lenAdn)
+      break;
+    iSlot = (iSlot + 1) & (that->_nbSlot - 1);
+  }
+  return iSlot;
+}
+
+// Search the evaluation of the adn 'adn' in the cache 'that'
+// Return true and set 'eval' if found, false else
+static bool PTPEEvalCacheGet(const PTPEEvalCache* const that,
+  const VecFloat* const adn, float* const eval) {
+  long iSlot = PTPEEvalCacheGetSlot(that, adn);
+  if (!(that->_isUsed[iSlot]))
+    return false;
+  *eval = that->_evals[iSlot];
+  return true;
+}
+
+// Add the evaluation 'eval' of the adn 'adn' in the cache 'that'
+static void PTPEEvalCachePut(PTPEEvalCache* const that,
+  const VecFloat* const adn, const float eval) {
+  long iSlot = PTPEEvalCacheGetSlot(that, adn);
+  if (!(that->_isUsed[iSlot])) {
+    float* slotAdn = that->_adns + iSlot * that->_lenAdn;
+    for (int i = 0; i < that->_lenAdn; ++i)
+      slotAdn[i] = VecGet(adn, i);
+    that->_isUsed[iSlot] = true;
+  }
+  that->_evals[iSlot] = eval;
+}
+
+// Return the evaluation above which an adn can't be one of the elites
+// of the GenAlg of the argument 'evalArg', from the evaluations
+// already known
+static float PTPEInitGetCutoff(const PTPEInitEvalArg* const evalArg,
+  const int iIsland) {
+  const GenAlg* ga = evalArg->_gas[iIsland];
+  int nbAdn = GAGetNbAdns(ga);
+  const float* evals = evalArg->_evals + iIsland * nbAdn;
+  const bool* isKnown = evalArg->_isKnown + iIsland * nbAdn;
+  float* known = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(float) * nbAdn);
+  int nbKnown = 0;
+  for (int iEnt = 0; iEnt < nbAdn; ++iEnt)
+    if (isKnown[iEnt])
+      known[nbKnown++] = evals[iEnt];
+  // If there are at least as many known evaluations as elites, an adn
+  // worse than the worst of the best known ones can't be an elite
+  float cutoff = HUGE_VAL;
+  if (nbKnown >= GAGetNbElites(ga) && GAGetNbElites(ga) > 0) {
+    qsort(known, nbKnown, sizeof(float), PTPECmpFloat);
+    cutoff = known[GAGetNbElites(ga) - 1];
+  }
+  free(known);
+  return cutoff;
+}
+
+// Get the bounds 'bounds' of the adns for the calibration of the
+// estimator 'that' with the POV in the bounding box 'POVmin'-'POVmax'
+// Return the length of the adns
+static int PTPEInitGetBounds(const PixelToPosEstimator* const that, 
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax,
+  float bounds[PTPE_NBPARAM][2]) {
+  if (that->_model == PTPEModel5DOF) {
+    float boundsYawPitch[2][2];
+    PTPEGet5DOFBounds(that, POVmin, POVmax, boundsYawPitch);
+    // yaw
+    bounds[0][0] = boundsYawPitch[0][0];
+    bounds[0][1] = boundsYawPitch[0][1];
+    // pitch
+    bounds[1][0] = boundsYawPitch[1][0];
+    bounds[1][1] = boundsYawPitch[1][1];
+    // roll, Sx, Sy
+    for (int i = 2; i < 5; ++i) {
+      bounds[i][0] = -PBMATH_HALFPI;
+      bounds[i][1] = PBMATH_HALFPI;
+    }
+    return PTPE_NBPARAM5DOF;
+  } else {
+    // Px, Py, Pz
+    for (int i = 0; i < 3; ++i) {
+      bounds[i][0] = VecGet(POVmin, i);
+      bounds[i][1] = VecGet(POVmax, i);
+    }
+    // Sx, Sy
+    for (int i = 3; i < 5; ++i) {
+      bounds[i][0] = -PBMATH_HALFPI;
+      bounds[i][1] = PBMATH_HALFPI;
+    }
+    // Upx, Upy, Upz
+    for (int i = 5; i < 8; ++i) {
+      bounds[i][0] = -1.0;
+      bounds[i][1] = 1.0;
+    }
+    bounds[6][0] = 0.0;
+    return PTPE_NBPARAM;
+  }
+}
+
+// Create a GenAlg for the calibration with adns of length 'lenAdn'
+// and bounds 'bounds'
+static GenAlg* PTPEInitCreateGenAlg(const int lenAdn,
+  const float bounds[PTPE_NBPARAM][2]) {
+  // Create the GenAlg
+  int lengthAdnI = 0;
+  GenAlg* ga = GenAlgCreate(GENALG_NBENTITIES, GENALG_NBELITES, 
+    lenAdn, lengthAdnI);
+  // Set the boundaries for the parameters
+  VecFloat2D boundsF = VecFloatCreateStatic2D();
+  for (int i = 0; i < lenAdn; ++i) {
+    VecSet(&boundsF, 0, bounds[i][0]); 
+    VecSet(&boundsF, 1, bounds[i][1]);
+    GASetBoundsAdnFloat(ga, i, &boundsF);
+  }
+  return ga;
+}
+
+// Return the diversity of the population of the GenAlg 'ga' with
+// bounds 'bounds', the average over the values of the adns of their
+// standard deviation relative to the range of their bounds
+static float PTPEInitGetDiversity(const GenAlg* const ga, 
+  const float bounds[PTPE_NBPARAM][2]) {
+  int nbAdn = GAGetNbAdns(ga);
+  int lenAdn = VecGetDim(GAAdnAdnF(GAAdn(ga, 0)));
+  float diversity = 0.0;
+  for (int i = 0; i < lenAdn; ++i) {
+    float range = bounds[i][1] - bounds[i][0];
+    if (range < PBMATH_EPSILON)
+      continue;
+    float sum = 0.0;
+    float sumSq = 0.0;
+    for (int iEnt = 0; iEnt < nbAdn; ++iEnt) {
+      float v = (VecGet(GAAdnAdnF(GAAdn(ga, iEnt)), i) - bounds[i][0]) 
+        / range;
+      sum += v;
+      sumSq += v * v;
+    }
+    float mean = sum / (float)nbAdn;
+    float var = sumSq / (float)nbAdn - mean * mean;
+    diversity += (var > 0.0 ? sqrt(var) : 0.0);
+  }
+  return diversity / (float)lenAdn;
+}
+
+// Copy the best adn of each island of the argument 'evalArg' over the
+// worst adn of the next island, and memorize its evaluation in the
+// caches 'caches' of the islands
+static void PTPEInitMigrate(PTPEInitEvalArg* const evalArg,
+  PTPEEvalCache** const caches) {
+  int nbIsland = evalArg->_nbIsland;
+  int nbAdn = GAGetNbAdns(evalArg->_gas[0]);
+  // Copy the best adns of all the islands before modifying them
+  VecFloat** migrants = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(VecFloat*) * nbIsland);
+  float* migrantEvals = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(float) * nbIsland);
+  for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+    const float* evals = evalArg->_evals + iIsland * nbAdn;
+    int iBest = 0;
+    for (int iEnt = 1; iEnt < nbAdn; ++iEnt)
+      if (evals[iEnt] < evals[iBest])
+        iBest = iEnt;
+    migrants[iIsland] = 
+      VecClone(GAAdnAdnF(GAAdn(evalArg->_gas[iIsland], iBest)));
+    migrantEvals[iIsland] = evals[iBest];
+  }
+  // Replace the worst adn of each island by the best one of the
+  // previous island in the ring
+  for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+    int iFrom = (iIsland + nbIsland - 1) % nbIsland;
+    GenAlg* ga = evalArg->_gas[iIsland];
+    float* evals = evalArg->_evals + iIsland * nbAdn;
+    int iWorst = 0;
+    for (int iEnt = 1; iEnt < nbAdn; ++iEnt)
+      if (evals[iEnt] > evals[iWorst])
+        iWorst = iEnt;
+    VecCopy(GAAdnAdnF(GAAdn(ga, iWorst)), migrants[iFrom]);
+    GASetAdnValue(ga, GAAdn(ga, iWorst), -1.0 * migrantEvals[iFrom]);
+    evals[iWorst] = migrantEvals[iFrom];
+    PTPEEvalCachePut(caches[iIsland], migrants[iFrom], 
+      migrantEvals[iFrom]);
+  }
+  // Free memory
+  for (int iIsland = 0; iIsland < nbIsland; ++iIsland)
+    VecFree(migrants + iIsland);
+  free(migrants);
+  free(migrantEvals);
+}
+
+// Comparison function for qsort of floats in ascending order
+static int PTPECmpFloat(const void* a, const void* b) {
+  float fa = *(const float*)a;
+  float fb = *(const float*)b;
+  return (fa > fb) - (fa < fb);
+}
+
+// Init the GenAlgs 'gas' of the 'nbIsland' islands with the random
+// number generator states 'rndStates' (null to use the current state)
+static void PTPEInitIslands(GenAlg** const gas, const int nbIsland,
+  unsigned int* const rndStates) {
+  for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+    if (rndStates != NULL)
+      PTPESeedIsland(rndStates, iIsland);
+    GAInit(gas[iIsland]);
+  }
+}
+
+// Seed the random number generators (rand and random) used by the
+// GenAlg of the island 'iIsland' from its own state in 'rndStates'
+// (cf rand_r), so each island draws a reproducible sequence whatever
+// the implementation of rand and random
+static void PTPESeedIsland(unsigned int* const rndStates,
+  const int iIsland) {
+  unsigned int seed = rand_r(rndStates + iIsland);
+  srand(seed);
+  srandom(seed);
+}
+
+// Run the genetic algorithm calibrating the estimator 'that' on the
+// data set 'dataset' with the adns of the model 'model' in the bounds
+// 'bounds', until one of the conditions 'end' is met
+// If 'seed' is not null it is inserted in the initial populations
+// 'bestAdn' is set to the best adn found, the statistics of 'that'
+// are updated
+// Return the reason of the end of the calibration
+static PTPEStopReason PTPEInitRun(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const PTPEModel model,
+  const float bounds[PTPE_NBPARAM][2], const PTPEInitEnd* const end,
+  const VecFloat* const seed, VecFloat* const bestAdn) {
+  // Number of islands
+  int nbIsland = that->_nbIsland;
+  // Create the random number generator states of the islands, seeded
+  // from the current state, the single island uses the current state
+  // to give the same result as without islands
+  unsigned int* rndStates = NULL;
+  if (nbIsland > 1) {
+    rndStates = PBErrMalloc(PixelToPosEstimatorErr,
+      sizeof(unsigned int) * nbIsland);
+    for (int iIsland = 0; iIsland < nbIsland; ++iIsland)
+      rndStates[iIsland] = random();
+  }
+  // Create and init the GenAlgs of the islands
+  int lengthAdnF = 
+    (model == PTPEModel5DOF ? PTPE_NBPARAM5DOF : PTPE_NBPARAM);
+  GenAlg** gas = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(GenAlg*) * nbIsland);
+  for (int iIsland = 0; iIsland < nbIsland; ++iIsland)
+    gas[iIsland] = PTPEInitCreateGenAlg(lengthAdnF, bounds);
+  PTPEInitIslands(gas, nbIsland, rndStates);
+  int nbAdn = GAGetNbAdns(gas[0]);
+  // Insert the seed in the populations
+  if (seed != NULL)
+    for (int iIsland = 0; iIsland < nbIsland; ++iIsland)
+      VecCopy(GAAdnAdnF(GAAdn(gas[iIsland], 0)), seed);
+  // Create the pool of threads evaluating the adns
+  PTPEPool* pool = PTPEPoolCreate(that->_nbThread);
+  PTPEInitEvalArg evalArg;
+  evalArg._estimator = that;
+  evalArg._model = model;
+  evalArg._gas = gas;
+  evalArg._nbIsland = nbIsland;
+  evalArg._dataset = dataset;
+  evalArg._evals = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(float) * nbIsland * nbAdn);
+  evalArg._isKnown = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(bool) * nbIsland * nbAdn);
+  evalArg._isRejected = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(bool) * nbIsland * nbAdn);
+  evalArg._cutoffs = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(float) * nbIsland);
+  // Create the caches of the evaluations of the previous and current
+  // epochs for each island
+  PTPEEvalCache** cachePrev = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(PTPEEvalCache*) * nbIsland);
+  PTPEEvalCache** cacheCur = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(PTPEEvalCache*) * nbIsland);
+  for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+    cachePrev[iIsland] = PTPEEvalCacheCreate(lengthAdnF, nbAdn);
+    cacheCur[iIsland] = PTPEEvalCacheCreate(lengthAdnF, nbAdn);
+  }
+  // History of the best value of the current run over the
+  // stagnation window, as a ring buffer
+  const PTPEStagnation* stagnation = end->_stagnation;
+  unsigned int window = stagnation->_window;
+  float* history = NULL;
+  if (stagnation->_policy != PTPEStagnationIgnore && window > 0)
+    history = PBErrMalloc(PixelToPosEstimatorErr, 
+      sizeof(float) * window);
+  // Variables to memorize the value of the best adn, over all the
+  // runs and over the current run
+  float best = 10000.0;
+  float bestRun = 10000.0;
+  // Loop on epochs
+  unsigned long epoch = 0;
+  unsigned long epochRun = 0;
+  PTPEStopReason stopReason = PTPEStopReasonNbEpoch;
+  float diversity = 0.0;
+  do {
+    //printf("epoch %ld avg err %fm     \r", 
+    //  epoch, best / (float)PTPEDatasetGetNb(dataset));
+    //fflush(stdout);
+    // Reuse the evaluations of the adns unchanged since the previous
+    // epoch
+    for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+      for (int iEnt = 0; iEnt < nbAdn; ++iEnt) {
+        int iAdn = iIsland * nbAdn + iEnt;
+        evalArg._isKnown[iAdn] = PTPEEvalCacheGet(cachePrev[iIsland], 
+          GAAdnAdnF(GAAdn(gas[iIsland], iEnt)), evalArg._evals + iAdn);
+        evalArg._isRejected[iAdn] = false;
+        if (evalArg._isKnown[iAdn])
+          ++(that->_stat._nbCacheHit);
+        else
+          ++(that->_stat._nbEval);
+      }
+      // Stop the evaluation of the adns which can't be better than
+      // the known elites of their island
+      evalArg._cutoffs[iIsland] = PTPEInitGetCutoff(&evalArg, iIsland);
+    }
+    // Evaluate the other adns in parallel
+    PTPEPoolRun(pool, PTPEInitEvalJob, &evalArg);
+    // Loop on adns, in order to get the same result whatever the
+    // number of threads
+    for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+      GenAlg* ga = gas[iIsland];
+      for (int iEnt = 0; iEnt < nbAdn; ++iEnt) {
+        int iAdn = iIsland * nbAdn + iEnt;
+        float ev = evalArg._evals[iAdn];
+        // Memorize the evaluation for the next epoch, unless it's only
+        // a lower bound
+        if (evalArg._isRejected[iAdn])
+          ++(that->_stat._nbRejected);
+        else
+          PTPEEvalCachePut(cacheCur[iIsland], 
+            GAAdnAdnF(GAAdn(ga, iEnt)), ev);
+        // Update the value of this adn
+        GASetAdnValue(ga, GAAdn(ga, iEnt), -1.0 * ev);
+        // Update the best values if necessary
+        if (ev < bestRun)
+          bestRun = ev;
+        if (ev < best) {
+          VecCopy(bestAdn, GAAdnAdnF(GAAdn(ga, iEnt)));
+          if (ev < best - PBMATH_EPSILON) {
+            if (that->_progress != NULL) {
+              that->_progress(ev, epoch, PTPEGetTime() - end->_start,
+                that->_progressData);
+            } else {
+              printf("%lu %f ", epoch, ev);
+              VecFloatPrint(GAAdnAdnF(GAAdn(ga, iEnt)), stdout, 6);
+              printf("        \n"); fflush(stdout);
+            }
+          }
+          best = ev;
+        }
+      }
+    }
+    ++epoch;
+    ++epochRun;
+    // Check for stagnation of the current run: the relative
+    // improvement of its best value over the window is too small or
+    // the populations have collapsed
+    bool isStagnating = false;
+    if (history != NULL) {
+      unsigned int iHistory = epochRun % window;
+      if (epochRun > window) {
+        float prevBest = history[iHistory];
+        float improvement = (prevBest > PBMATH_EPSILON ? 
+          (prevBest - bestRun) / prevBest : 0.0);
+        diversity = 0.0;
+        for (int iIsland = 0; iIsland < nbIsland; ++iIsland)
+          diversity += PTPEInitGetDiversity(gas[iIsland], bounds);
+        diversity /= (float)nbIsland;
+        isStagnating = 
+          (improvement < stagnation->_minImprovement ||
+          diversity < stagnation->_minDiversity);
+      }
+      history[iHistory] = bestRun;
+    }
+    if (best <= end->_prec) {
+      stopReason = PTPEStopReasonPrec;
+    } else if (end->_cancel != NULL && atomic_load(end->_cancel)) {
+      stopReason = PTPEStopReasonCancel;
+    } else if (end->_deadline > 0.0 && 
+      PTPEGetTime() >= end->_deadline) {
+      stopReason = PTPEStopReasonTimeBudget;
+    } else if (isStagnating && 
+      stagnation->_policy == PTPEStagnationStop) {
+      stopReason = PTPEStopReasonStagnation;
+    } else if (isStagnating && 
+      stagnation->_policy == PTPEStagnationRestart) {
+      // Restart the populations from scratch, the best adn is kept
+      // aside
+      PTPEInitIslands(gas, nbIsland, rndStates);
+      for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+        PTPEEvalCacheClear(cachePrev[iIsland]);
+        PTPEEvalCacheClear(cacheCur[iIsland]);
+      }
+      bestRun = 10000.0;
+      epochRun = 0;
+      ++(that->_stat._nbRestart);
+      continue;
+    }
+    // Exchange the best adns between islands if necessary
+    if (nbIsland > 1 && that->_migrationPeriod > 0 &&
+      epochRun % that->_migrationPeriod == 0)
+      PTPEInitMigrate(&evalArg, cacheCur);
+    // Swap the caches
+    for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+      PTPEEvalCache* cache = cachePrev[iIsland];
+      cachePrev[iIsland] = cacheCur[iIsland];
+      cacheCur[iIsland] = cache;
+      PTPEEvalCacheClear(cacheCur[iIsland]);
+    }
+    // Step the GenAlgs, each with the random number generator of its
+    // island
+    for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+      if (rndStates != NULL)
+        PTPESeedIsland(rndStates, iIsland);
+      GAStep(gas[iIsland]);
+    }
+  } while (epoch < end->_nbEpoch && 
+    stopReason == PTPEStopReasonNbEpoch);
+  that->_stat._nbEpoch += epoch;
+  that->_stat._diversity = diversity;
+  that->_stat._stopReason = stopReason;
+  that->_stat._bestErr = best;
+  // Free memory
+  PTPEPoolFree(&pool);
+  free(evalArg._evals);
+  free(evalArg._isKnown);
+  free(evalArg._isRejected);
+  free(evalArg._cutoffs);
+  for (int iIsland = 0; iIsland < nbIsland; ++iIsland) {
+    PTPEEvalCacheFree(cachePrev + iIsland);
+    PTPEEvalCacheFree(cacheCur + iIsland);
+    GenAlgFree(gas + iIsland);
+  }
+  free(cachePrev);
+  free(cacheCur);
+  free(gas);
+  free(rndStates);
+  free(history);
+  // Return the reason of the end of the calibration
+  return stopReason;
+}
+
+// Reset the statistics 'that'
+static void PTPEInitStatReset(PTPEInitStat* const that) {
+  that->_nbEval = 0;
+  that->_nbCacheHit = 0;
+  that->_nbRejected = 0;
+  that->_nbEpoch = 0;
+  that->_nbRestart = 0;
+  that->_diversity = 0.0;
+  that->_stopReason = PTPEStopReasonNbEpoch;
+  that->_bestErr = 0.0;
+  that->_elapsed = 0.0;
+}
+
+// Return the current time in seconds of the monotonic clock
+double PTPEGetTime(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)(ts.tv_sec) + 1e-9 * (double)(ts.tv_nsec);
+}
+
+// Main function of the thread of the background calibration 'arg'
+// (PTPEBackground*)
+static void* PTPEBackgroundMain(void* arg) {
+  PTPEBackground* background = (PTPEBackground*)arg;
+  // Calibrate the private copy of the estimator
+  background->_stopReason = PTPEInitDatasetBudget(
+    &(background->_estimator), background->_dataset,
+    background->_nbEpoch, background->_prec, &(background->_POVmin),
+    &(background->_POVmax), 0.0, &(background->_cancel));
+  // Publish the compiled projection unless the calibration has been
+  // cancelled, the snapshot is fully written before the release store
+  // makes it visible to the queries
+  if (background->_stopReason != PTPEStopReasonCancel) {
+    background->_snapshot =
+      PBErrMalloc(PixelToPosEstimatorErr, sizeof(PTPEProj));
+    PTPECompile(&(background->_estimator));
+    *(background->_snapshot) = background->_estimator._proj;
+    background->_replaced = (PTPEProj*)atomic_exchange(
+      &(background->_target->_live), background->_snapshot);
+  }
+  atomic_store_explicit(&(background->_isDone), true,
+    memory_order_release);
+  return NULL;
+}
+
+// Publish the camera position, image dimensions and projection
+// parameters of the estimator 'that' into the POSIX shared memory
+// segment 'name' (e.g. "/ptpe"), with the grid of the lookup table
+// (cf PTPELutCreate) if 'withGrid' is true
+// The segment is updated in place under its sequence counter (cf
+// PTPEShmBeginRead), if its size changes it is marked as stale and
+// replaced by a new segment of the same name (cf PTPEShmIsStale)
+// There must be only one publisher per segment at a time
+// Return true if the segment could be published, false else
+bool PTPEShmPublish(const PixelToPosEstimator* const that,
+  const char* const name, const bool withGrid) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (name == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'name' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Size of the segment
+  long nbNodeX = (withGrid ? (long)VecGet(&(that->_imgSize), 0) + 1 : 0);
+  long nbNodeY = (withGrid ? (long)VecGet(&(that->_imgSize), 1) + 1 : 0);
+  size_t size = sizeof(PTPEShmHeader) +
+    sizeof(float) * 2 * nbNodeX * nbNodeY;
+  // Open the segment, replace it if its size is different
+  int fd = shm_open(name, O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  if (st.st_size != 0 && (size_t)st.st_size != size) {
+    // Readers of the current segment keep their mapping until they
+    // notice it's stale
+    if ((size_t)st.st_size >= sizeof(PTPEShmHeader)) {
+      PTPEShmHeader* old = mmap(NULL, sizeof(PTPEShmHeader),
+        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (old != MAP_FAILED) {
+        atomic_store(&(old->_isStale), 1);
+        munmap(old, sizeof(PTPEShmHeader));
+      }
+    }
+    close(fd);
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+      return false;
+    st.st_size = 0;
+  }
+  if (st.st_size == 0 && ftruncate(fd, size) != 0) {
+    close(fd);
+    return false;
+  }
+  PTPEShmHeader* header =
+    mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (header == MAP_FAILED)
+    return false;
+  // Start the publication, readers retry until it ends
+  unsigned int seq = atomic_load_explicit(&(header->_seq),
+    memory_order_relaxed);
+  atomic_store_explicit(&(header->_seq), seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  // Write the header and the grid
+  memcpy(header->_magic, PTPE_SHM_MAGIC, 8);
+  header->_version = PTPE_SHM_VERSION;
+  header->_nbNodeX = nbNodeX;
+  header->_nbNodeY = nbNodeY;
+  for (int i = 3; i--;)
+    header->_cameraPos[i] = VecGet(&(that->_cameraPos), i);
+  for (int i = 2; i--;)
+    header->_imgSize[i] = VecGet(&(that->_imgSize), i);
+  for (int iParam = PTPE_NBPARAM; iParam--;)
+    header->_param[iParam] = VecGet(that->_param, iParam);
+  if (withGrid)
+    PTPELutFill(that, nbNodeX, nbNodeY, (float*)(header + 1));
+  // End the publication
+  atomic_store_explicit(&(header->_seq), seq + 2, memory_order_release);
+  munmap(header, size);
+  return true;
+}
+
+// Map read only the shared memory segment 'name' published by
+// PTPEShmPublish
+// Return NULL if the segment can't be mapped or is invalid
+PTPEShm* PTPEShmOpen(const char* const name) {
+#if BUILDMODE == 0
+  if (name == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'name' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Map the segment
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+    (size_t)st.st_size < sizeof(PTPEShmHeader)) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = st.st_size;
+  void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return NULL;
+  // Check the header, the magic number is written by the first
+  // publication
+  PTPEShm shm;
+  shm._data = data;
+  shm._size = size;
+  const PTPEShmHeader* header = data;
+  uint32_t seq = PTPEShmBeginRead(&shm);
+  bool isValid =
+    (strncmp(header->_magic, PTPE_SHM_MAGIC, 8) == 0) &&
+    header->_version == PTPE_SHM_VERSION &&
+    size == sizeof(PTPEShmHeader) +
+      sizeof(float) * 2 * header->_nbNodeX * header->_nbNodeY;
+  shm._lut._nbNodeX = header->_nbNodeX;
+  shm._lut._nbNodeY = header->_nbNodeY;
+  if (!PTPEShmEndRead(&shm, seq) || !isValid) {
+    munmap(data, size);
+    return NULL;
+  }
+  // Create the mapping, its lookup table uses the grid without copy
+  PTPEShm* that = PBErrMalloc(PixelToPosEstimatorErr, sizeof(PTPEShm));
+  *that = shm;
+  that->_lut._meter = (const float*)(header + 1);
+  that->_lut._data = NULL;
+  that->_lut._size = 0;
+  that->_lut._isMapped = true;
+  // Return the mapping
+  return that;
+}
+
+// Unmap the shared memory segment 'that'
+void PTPEShmClose(PTPEShm** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  munmap((*that)->_data, (*that)->_size);
+  free(*that);
+  *that = NULL;
+}
+
+// Return true if the shared memory segment 'that' has been replaced
+// by a new one, it must then be closed and opened again
+bool PTPEShmIsStale(const PTPEShm* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  const PTPEShmHeader* header = that->_data;
+  return atomic_load(&(header->_isStale)) != 0;
+}
+
+// Wait for the end of the current publication in the shared memory
+// segment 'that' and return its sequence counter
+// The values read from the segment (grid included) after this call
+// are consistent if PTPEShmEndRead returns true for the returned
+// counter, else they must be read again
+uint32_t PTPEShmBeginRead(const PTPEShm* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  PTPEShmHeader* header = that->_data;
+  uint32_t seq = 0;
+  while ((seq = atomic_load_explicit(&(header->_seq),
+    memory_order_acquire)) % 2 == 1)
+    sched_yield();
+  return seq;
+}
+
+// Return true if the shared memory segment 'that' hasn't been
+// published again since PTPEShmBeginRead returned 'seq'
+bool PTPEShmEndRead(const PTPEShm* const that, const uint32_t seq) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  PTPEShmHeader* header = that->_data;
+  atomic_thread_fence(memory_order_acquire);
+  return atomic_load_explicit(&(header->_seq),
+    memory_order_relaxed) == seq;
+}
+
+// Get the lookup table of the grid of the shared memory segment
+// 'that', it has no node if the segment has been published without
+// grid
+const PTPELut* PTPEShmGetLut(const PTPEShm* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  return &(that->_lut);
+}
+
+// Create the estimator 'estimator' with the camera position, image
+// dimensions and projection parameters of the shared memory segment
+// 'that', compiled and ready to use without recalibration
+// Return the sequence counter of the values read
+uint32_t PTPEShmGetEstimator(const PTPEShm* const that,
+  PixelToPosEstimator* const estimator) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (estimator == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'estimator' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  const PTPEShmHeader* header = that->_data;
+  // Copy the values until they are consistent
+  PTPEShmHeader copy;
+  uint32_t seq = 0;
+  do {
+    seq = PTPEShmBeginRead(that);
+    memcpy(copy._cameraPos, header->_cameraPos, sizeof(float) * 3);
+    memcpy(copy._imgSize, header->_imgSize, sizeof(float) * 2);
+    memcpy(copy._param, header->_param, sizeof(float) * PTPE_NBPARAM);
+  } while (!PTPEShmEndRead(that, seq));
+  // Create the estimator
+  VecFloat3D cameraPos = VecFloatCreateStatic3D();
+  VecFloat2D imgSize = VecFloatCreateStatic2D();
+  for (int i = 3; i--;)
+    VecSet(&cameraPos, i, copy._cameraPos[i]);
+  for (int i = 2; i--;)
+    VecSet(&imgSize, i, copy._imgSize[i]);
+  *estimator = PixelToPosEstimatorCreateStatic(&cameraPos, &imgSize);
+  for (int iParam = PTPE_NBPARAM; iParam--;)
+    VecSet(estimator->_param, iParam, copy._param[iParam]);
+  PTPECompile(estimator);
+  return seq;
+}
+
+// Create a new PTPEEllipse for the camera at 'posCamera', the image of
+// dimensions 'imgSize' and the point of view at 'povPos'
+PTPEEllipse PTPEEllipseCreateStatic(
+  const VecFloat3D* const posCamera, const VecFloat2D* const imgSize,
+  const VecFloat3D* const povPos) {
+#if BUILDMODE == 0
+  if (posCamera == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'posCamera' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (imgSize == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'imgSize' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (povPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'povPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Declare the new estimator
+  PTPEEllipse estimator;
+  // Init the estimator
+  estimator._cameraPos = *posCamera;
+  estimator._imgSize = *imgSize;
+  estimator._povPos = *povPos;
+  estimator._param = VecFloatCreate(PTPE_ELLIPSE_NBPARAM);
+  // Return the new estimator
+  return estimator;
+}
+
+// Free memory used by the PTPEEllipse 'that'
+void PTPEEllipseFreeStatic(PTPEEllipse* const that) {
+  if (that == NULL)
+    return;
+  VecFree(&(that->_param));
+}
+
+// Set the projection parameters of the PTPEEllipse 'that' to 'param'
+void PTPEEllipseSetParam(PTPEEllipse* const that,
+  const VecFloat* const param) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (param == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'param' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (VecGetDim(param) != PTPE_ELLIPSE_NBPARAM) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg,
+      "'param' 's dimension is invalid (%d==%d)",
+      VecGetDim(param), PTPE_ELLIPSE_NBPARAM);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  VecCopy(that->_param, param);
+}
+
+// Calculate the projection parameters of the PTPEEllipse 'that' with
+// the correspondences of the data set 'dataset', with a genetic
+// algorithm minimizing the average distance in pixels between their
+// screen positions and the projection of their real positions
+// Stops after 'nbEpoch' epochs or when the average distance gets
+// below 'prec'
+// Return the average distance of the resulting parameters
+float PTPEEllipseInitDataset(PTPEEllipse* const that,
+  const PTPEDataset* const dataset, const unsigned int nbEpoch,
+  const float prec) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'dataset' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (dataset->_nb <= 2) {
+    PixelToPosEstimatorErr->_type = PBErrTypeInvalidArg;
+    sprintf(PixelToPosEstimatorErr->_msg,
+      "'dataset' doesn't have enough elements (%ld>2)", dataset->_nb);
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // The polar positions don't depend on the parameters
+  VecFloat2D* polarPos = PBErrMalloc(PixelToPosEstimatorErr,
+    sizeof(VecFloat2D) * dataset->_nb);
+  for (long iPos = dataset->_nb; iPos--;) {
+    VecFloat3D realPos = VecFloatCreateStatic3D();
+    VecSet(&realPos, 0, dataset->_meterX[iPos]);
+    VecSet(&realPos, 2, dataset->_meterZ[iPos]);
+    polarPos[iPos] = PTPEEllipseGetMeterToPolar(that, &realPos);
+  }
+  // Create the genetic algorithm
+  GenAlg* ga = GenAlgCreate(GENALG_NBENTITIES, GENALG_NBELITES,
+    PTPE_ELLIPSE_NBPARAM, 0);
+  float bounds[PTPE_ELLIPSE_NBPARAM][2] = {
+    {PBMATH_QUARTERPI, 3.0 * PBMATH_QUARTERPI}, // theta0
+    {10.0, 100.0}, // f
+    {0.0, 10000.0}, // Sx
+    {0.0, 10000.0}, // Sy
+    {0.3 * VecGet(&(that->_imgSize), 0),
+      0.6 * VecGet(&(that->_imgSize), 0)}, // Ox
+    {VecGet(&(that->_imgSize), 1),
+      5.0 * VecGet(&(that->_imgSize), 1)}}; // Oy
+  for (int iParam = PTPE_ELLIPSE_NBPARAM; iParam--;) {
+    VecFloat2D boundsF = VecFloatCreateStatic2D();
+    VecSet(&boundsF, 0, bounds[iParam][0]);
+    VecSet(&boundsF, 1, bounds[iParam][1]);
+    GASetBoundsAdnFloat(ga, iParam, &boundsF);
+  }
+  GAInit(ga);
+  // Loop on epochs
+  float best = -1.0;
+  VecFloat* param = that->_param;
+  for (unsigned int iEpoch = 0; iEpoch < nbEpoch &&
+    (best < 0.0 || best > prec); ++iEpoch) {
+    // Evaluate the adns
+    for (int iEnt = 0; iEnt < GAGetNbAdns(ga); ++iEnt) {
+      that->_param = GAAdnAdnF(GAAdn(ga, iEnt));
+      float err = 0.0;
+      for (long iPos = dataset->_nb; iPos--;) {
+        VecFloat2D screenPos =
+          PTPEEllipseGetPolarToPx(that, polarPos + iPos);
+        err += sqrt(
+          fastpow(VecGet(&screenPos, 0) - dataset->_pxX[iPos], 2) +
+          fastpow(VecGet(&screenPos, 1) - dataset->_pxY[iPos], 2));
+      }
+      err /= (float)(dataset->_nb);
+      if (!isfinite(err))
+        err = 1e30;
+      GASetAdnValue(ga, GAAdn(ga, iEnt), -1.0 * err);
+      if (best < 0.0 || err < best) {
+        best = err;
+        VecCopy(param, that->_param);
+      }
+    }
+    GAStep(ga);
+  }
+  that->_param = param;
+  // Free memory
+  GenAlgFree(&ga);
+  free(polarPos);
+  // Return the average distance
+  return best;
+}
+
+// Convert the real position 'realPos' to a polar position
+// (theta, dist) for the PTPEEllipse 'that'
+// theta in [-PI,PI], dist in meter
+VecFloat2D PTPEEllipseGetMeterToPolar(const PTPEEllipse* const that,
+  const VecFloat3D* const realPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (realPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'realPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Declare a variable to memorize the result
+  VecFloat2D res = VecFloatCreateStatic2D();
+  // Vectors from the camera's ground position to the real position
+  // and to the point of view, in the (x, z) plane
+  double cpX = VecGet(realPos, 0) - VecGet(&(that->_cameraPos), 0);
+  double cpZ = VecGet(realPos, 2) - VecGet(&(that->_cameraPos), 2);
+  double povX = VecGet(&(that->_povPos), 0) -
+    VecGet(&(that->_cameraPos), 0);
+  double povZ = VecGet(&(that->_povPos), 2) -
+    VecGet(&(that->_cameraPos), 2);
+  // The angle is the one of the rotation of the real position onto the
+  // point of view
+  VecSet(&res, 0, atan2(cpX * povZ - cpZ * povX, cpX * povX + cpZ * povZ));
+  VecSet(&res, 1, sqrt(cpX * cpX + cpZ * cpZ));
+  // Return the result
+  return res;
+}
+
+// Convert the polar position 'polarPos' (theta, dist) to a real
+// position for the PTPEEllipse 'that'
+VecFloat3D PTPEEllipseGetPolarToMeter(const PTPEEllipse* const that,
+  const VecFloat2D* const polarPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (polarPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'polarPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Declare a variable to memorize the result
+  VecFloat3D res = VecFloatCreateStatic3D();
+  // Direction of the point of view in the (x, z) plane
+  double povX = VecGet(&(that->_povPos), 0) -
+    VecGet(&(that->_cameraPos), 0);
+  double povZ = VecGet(&(that->_povPos), 2) -
+    VecGet(&(that->_cameraPos), 2);
+  double norm = sqrt(povX * povX + povZ * povZ);
+  // Rotate it by theta around the vertical axis and scale it by the
+  // distance
+  double c = cos(VecGet(polarPos, 0));
+  double s = sin(VecGet(polarPos, 0));
+  double k = VecGet(polarPos, 1) / norm;
+  VecSet(&res, 0, VecGet(&(that->_cameraPos), 0) +
+    k * (c * povX + s * povZ));
+  VecSet(&res, 2, VecGet(&(that->_cameraPos), 2) +
+    k * (c * povZ - s * povX));
+  // Return the result
+  return res;
+}
+
+// Return Ry('dist') and its derivative in 'dRy' for the PTPEEllipse
+// 'that' (cf PTPEEllipse)
+static double PTPEEllipseGetRy(const PTPEEllipse* const that,
+  const double dist, double* const dRy) {
+  double theta0 = VecGet(that->_param, 0);
+  double f = VecGet(that->_param, 1);
+  double h = VecGet(&(that->_cameraPos), 1);
+  double t = tan(theta0 - atan(dist / h));
+  if (dRy != NULL)
+    *dRy = f * (1.0 + t * t) * h / (h * h + dist * dist);
+  return f * (tan(theta0) - t);
+}
+
+// Convert the polar position 'polarPos' (theta, dist) to a screen
+// position for the PTPEEllipse 'that'
+VecFloat2D PTPEEllipseGetPolarToPx(const PTPEEllipse* const that,
+  const VecFloat2D* const polarPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (polarPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'polarPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // Declare a variable to memorize the result
+  VecFloat2D res = VecFloatCreateStatic2D();
+  // Calculate the screen coordinates
+  double theta = VecGet(polarPos, 0);
+  double dist = VecGet(polarPos, 1);
+  double ry = PTPEEllipseGetRy(that, dist, NULL);
+  VecSet(&res, 0, VecGet(that->_param, 4) +
+    VecGet(that->_param, 2) * dist * sin(theta));
+  VecSet(&res, 1, VecGet(that->_param, 5) -
+    VecGet(that->_param, 3) * ry * cos(theta));
+  // Return the result
+  return res;
+}
+
+// Convert the screen position 'screenPos' to the polar position
+// 'polarPos' (theta in [-PI/2,PI/2], dist) for the PTPEEllipse 'that'
+// by inversion of PTPEEllipseGetPolarToPx: the distance is the root
+// of an equation increasing on the distances where the projection is
+// defined, solved with Newton iterations safeguarded by bisection,
+// then theta is deduced from the x coordinate
+// Return false if the screen position has no antecedent in front of
+// the camera within PTPE_ELLIPSE_MAXDIST meters ('polarPos' is then
+// set to the nearest one), true else
+bool PTPEEllipseGetPxToPolar(const PTPEEllipse* const that,
+  const VecFloat2D* const screenPos, VecFloat2D* const polarPos) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'that' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (screenPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'screenPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+  if (polarPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'polarPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  // a = dist * sin(theta) and b = Ry(dist) * cos(theta), then with
+  // cos(theta) >= 0 the distance is the root of
+  // g(dist) = Ry(dist) * sqrt(1 - (a / dist)^2) - b
+  // which is increasing for |a| <= dist < distMax, where distMax is
+  // the singularity of Ry where theta0 - atan(dist / h) = PI/2 if
+  // theta0 > PI/2 (beyond it Ry is negative and no real position is
+  // visible), infinite else
+  double a = (VecGet(screenPos, 0) - VecGet(that->_param, 4)) /
+    VecGet(that->_param, 2);
+  double b = (VecGet(that->_param, 5) - VecGet(screenPos, 1)) /
+    VecGet(that->_param, 3);
+  bool isValid = true;
+  if (b < 0.0) {
+    b = 0.0;
+    isValid = false;
+  }
+  double lo = fabs(a);
+  double hi = PTPE_ELLIPSE_MAXDIST;
+  double theta0 = VecGet(that->_param, 0);
+  if (theta0 > PBMATH_HALFPI) {
+    double distMax = VecGet(&(that->_cameraPos), 1) *
+      tan(theta0 - PBMATH_HALFPI) * (1.0 - 1e-6);
+    if (distMax < hi)
+      hi = distMax;
+  }
+  double dist = 0.0;
+  if (lo >= hi) {
+    dist = hi;
+    isValid = false;
+  } else if (PTPEEllipseGetRy(that, hi, NULL) *
+    sqrt(1.0 - a * a / (hi * hi)) < b) {
+    dist = hi;
+    isValid = false;
+  } else if (b == 0.0) {
+    dist = lo;
+  } else {
+    // Initial guess from the solution for a = 0
+    double u = theta0 - atan(tan(theta0) - b / VecGet(that->_param, 1));
+    double distB = (u > 0.0 && u < PBMATH_HALFPI ?
+      VecGet(&(that->_cameraPos), 1) * tan(u) : hi);
+    dist = sqrt(distB * distB + a * a);
+    if (dist <= lo || dist >= hi)
+      dist = 0.5 * (lo + hi);
+    // Newton iterations, falling back to bisection when the step
+    // leaves the bracket
+    for (int iIter = 0; iIter < PTPE_ELLIPSE_NBMAXITER; ++iIter) {
+      double dRy = 0.0;
+      double ry = PTPEEllipseGetRy(that, dist, &dRy);
+      double r = a / dist;
+      double s = sqrt(1.0 - r * r);
+      double g = ry * s - b;
+      if (g < 0.0)
+        lo = dist;
+      else
+        hi = dist;
+      double dg = dRy * s + (s > 0.0 ? ry * r * r / (dist * s) : 0.0);
+      double next = (dg > 0.0 ? dist - g / dg : lo);
+      if (next <= lo || next >= hi)
+        next = 0.5 * (lo + hi);
+      bool isConverged = (fabs(next - dist) <= 1e-9 * dist);
+      dist = next;
+      if (isConverged)
+        break;
+    }
+  }
+  VecSet(polarPos, 0, asin(fmax(-1.0, fmin(1.0, a / dist))));
+  VecSet(polarPos, 1, dist);
+  return isValid;
+}
+
+// Convert the screen position 'screenPos' to the real position
+// 'realPos' for the PTPEEllipse 'that' (cf PTPEEllipseGetPxToPolar)
+// Return false if the screen position has no antecedent in front of
+// the camera ('realPos' is then set to the nearest one), true else
+bool PTPEEllipseGetPxToMeter(const PTPEEllipse* const that,
+  const VecFloat2D* const screenPos, VecFloat3D* const realPos) {
+#if BUILDMODE == 0
+  if (realPos == NULL) {
+    PixelToPosEstimatorErr->_type = PBErrTypeNullPointer;
+    sprintf(PixelToPosEstimatorErr->_msg, "'realPos' is null");
+    PBErrCatch(PixelToPosEstimatorErr);
+  }
+#endif
+  VecFloat2D polarPos = VecFloatCreateStatic2D();
+  bool isValid = PTPEEllipseGetPxToPolar(that, screenPos, &polarPos);
+  *realPos = PTPEEllipseGetPolarToMeter(that, &polarPos);
+  return isValid;
+}
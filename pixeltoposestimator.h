@@ -10,6 +10,15 @@
 #include <math.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 #include "pberr.h"
 #include "pbmath.h"
 #include "gset.h"
@@ -28,10 +37,176 @@
 
 #define PTPE_NBPARAM 8
 
+// Number of parameters of the 5 degrees of freedom model
+// (yaw, pitch, roll, Sx, Sy)
+#define PTPE_NBPARAM5DOF 5
+
+// Magic number and version of the lookup table files
+#define PTPE_LUT_MAGIC "PTPELUT"
+#define PTPE_LUT_VERSION 1
+
+// Alignment in bytes of the arrays of a PTPEDataset
+#define PTPE_DATASET_ALIGN 32
+
+// Magic number and version of the binary input files
+#define PTPE_INPUT_MAGIC "PTPEINP"
+#define PTPE_INPUT_VERSION 1
+
+// Magic number and version of the shared memory segments
+#define PTPE_SHM_MAGIC "PTPESHM"
+#define PTPE_SHM_VERSION 1
+
+// Default number of epochs between two migrations of the best adns
+// between islands in PTPEInit
+#define PTPE_MIGRATIONPERIOD 50
+
+// Default settings of the stagnation detection of PTPEInit
+#define PTPE_STAGNATIONWINDOW 1000
+#define PTPE_STAGNATIONMINIMPROVEMENT 0.001
+#define PTPE_STAGNATIONMINDIVERSITY 0.0001
+
+// Number of stages of PTPERecalibrate, the search radii are halved
+// at each stage
+#define PTPE_RECALIBNBSTAGE 5
+
+// Maximum number of iterations of the refinement in PTPEInit
+#define PTPE_REFINE_NBMAXITER 100
+
+// Maximum number of screen positions drawn per correspondence by
+// PTPEDatasetCreateSynthetic
+#define PTPE_SYNTHETIC_NBMAXTRY 1000
+
+// ------------- PTPEEllipse
+
+// Number of parameters of the plane/ellipse model
+// (theta, f, Sx, Sy, Ox, Oy)
+#define PTPE_ELLIPSE_NBPARAM 6
+
+// Maximum distance in meters from the camera of the real positions
+// calculated by PTPEEllipseGetPxToPolar
+#define PTPE_ELLIPSE_MAXDIST 10000.0
+
+// Maximum number of iterations of PTPEEllipseGetPxToPolar
+#define PTPE_ELLIPSE_NBMAXITER 60
+
 // ------------- PixelToPosEstimator
 
 // ================= Data structure ===================
 
+// Models of the parameters searched by PTPEInit
+typedef enum PTPEModel {
+  // The 8 projection parameters (Px, Py, Pz, Sx, Sy, Upx, Upy, Upz)
+  PTPEModelPOV,
+  // The 5 degrees of freedom of the camera (yaw, pitch, roll, Sx, Sy)
+  // cf PTPEParam5DOFToParam
+  PTPEModel5DOF
+} PTPEModel;
+
+// Compiled projection, derived once from the projection parameters and
+// the camera position
+// For a point at polar position (u, v), with c1, s1 the cos and sin
+// of Sx * u, and c2, s2 the cos and sin of Sy * v, the vector from
+// the camera to the point is (before normalisation):
+// V = F * (c1 - 1) + D * c2 + A * s1 + B * s2
+// with D = CP, A = Up x CP, B = Right x CP, F = CP - Up * (Up . CP)
+// (cf PTPEGetPolarToMeter)
+typedef struct PTPEProj {
+  // Flag to memorize if the compiled projection has been built
+  bool _isValid;
+  // Projection parameters the compiled projection was built from
+  float _param[PTPE_NBPARAM];
+  // Camera position
+  float _c[3];
+  // Vectors of the decomposition of V
+  float _d[3];
+  float _a[3];
+  float _b[3];
+  float _f[3];
+  // Conversion from polar position to rotation angles:
+  // Sx * u, Sy * v
+  float _sx;
+  float _sy;
+  // Conversion from screen position to rotation angles:
+  // Sx * u = _kx * screenX + _ox, Sy * v = _ky * screenY + _oy
+  float _kx;
+  float _ox;
+  float _ky;
+  float _oy;
+} PTPEProj;
+
+// Reasons of the end of PTPEInit
+typedef enum PTPEStopReason {
+  // The average error got below the requested precision
+  PTPEStopReasonPrec,
+  // The maximum number of epochs has been reached
+  PTPEStopReasonNbEpoch,
+  // The calibration stagnated (cf PTPESetStagnation)
+  PTPEStopReasonStagnation,
+  // The time budget has elapsed (cf PTPEInitDatasetBudget)
+  PTPEStopReasonTimeBudget,
+  // The calibration has been cancelled (cf PTPEInitDatasetBudget)
+  PTPEStopReasonCancel
+} PTPEStopReason;
+
+// Policies of PTPEInit when it stagnates
+typedef enum PTPEStagnationPolicy {
+  // Continue until the precision or the number of epochs is reached
+  PTPEStagnationIgnore,
+  // Stop the calibration
+  PTPEStagnationStop,
+  // Restart the populations from scratch, keeping the best adn aside
+  PTPEStagnationRestart
+} PTPEStagnationPolicy;
+
+// Settings of the stagnation detection of PTPEInit
+typedef struct PTPEStagnation {
+  // Policy when stagnating
+  PTPEStagnationPolicy _policy;
+  // Number of epochs over which the improvement is measured
+  unsigned int _window;
+  // Relative improvement of the best value over the window below
+  // which the calibration stagnates
+  float _minImprovement;
+  // Diversity of the populations below which the calibration
+  // stagnates
+  float _minDiversity;
+} PTPEStagnation;
+
+// Statistics of the last calibration by PTPEInit
+typedef struct PTPEInitStat {
+  // Number of evaluations of adns over the data set
+  unsigned long _nbEval;
+  // Number of evaluations of adns avoided because the adn was
+  // unchanged since the previous epoch
+  unsigned long _nbCacheHit;
+  // Number of evaluations of adns stopped early because the adn
+  // couldn't be one of the elites (cf PTPEEvaluateParamDatasetBounded)
+  unsigned long _nbRejected;
+  // Number of epochs and of restarts
+  unsigned long _nbEpoch;
+  unsigned long _nbRestart;
+  // Diversity of the populations at the end of the calibration, the
+  // average over the values of the adns of their standard deviation
+  // relative to the range of their bounds (only calculated when the
+  // stagnation is monitored)
+  float _diversity;
+  // Reason of the end of the calibration
+  PTPEStopReason _stopReason;
+  // Average error of the resulting projection parameters
+  float _bestErr;
+  // Duration of the calibration in seconds
+  double _elapsed;
+} PTPEInitStat;
+
+// Calibration running on a background thread (cf PTPEBackgroundStart)
+typedef struct PTPEBackground PTPEBackground;
+
+// Function called by PTPEInit each time the average error 'err' of
+// the best adn improves, at the epoch 'epoch', 'elapsed' seconds after
+// the start of the calibration, with the user data 'data'
+typedef void (*PTPEProgress)(const float err, const unsigned long epoch,
+  const double elapsed, void* const data);
+
 typedef struct PixelToPosEstimator {
   // Camera position
   VecFloat3D _cameraPos;
@@ -40,8 +215,134 @@ typedef struct PixelToPosEstimator {
   // Projection parameters
   // (Px, Py, Pz, Sx, Sy, Upx, Upy, Upz)
   VecFloat* _param;
+  // Compiled projection
+  PTPEProj _proj;
+  // Number of threads used to evaluate the population in PTPEInit
+  int _nbThread;
+  // Flag to memorize if PTPEInit refines the best adn of the genetic
+  // algorithm with PTPERefine
+  bool _flagRefine;
+  // Model of the parameters searched by PTPEInit
+  PTPEModel _model;
+  // Number of islands (independent populations) of PTPEInit and number
+  // of epochs between two migrations of their best adns
+  int _nbIsland;
+  unsigned int _migrationPeriod;
+  // Settings of the stagnation detection of PTPEInit
+  PTPEStagnation _stagnation;
+  // Statistics of the last calibration by PTPEInit
+  PTPEInitStat _stat;
+  // Homography from the screen positions to the real positions on
+  // the ground plane (x, z), row major, calculated by
+  // PTPEInitHomography
+  float _homography[9];
+  // Compiled projection published by the background calibration, used
+  // instead of '_proj' by the queries when not null, it is never
+  // modified once published
+  _Atomic(const PTPEProj*) _live;
+  // Epoch of the queries and number of queries in progress per parity
+  // of the epoch, a published compiled projection replaced by a newer
+  // one is freed, and the parameters and compiled projection of the
+  // estimator are modified while published, only once the queries
+  // which may be using them have ended
+  atomic_uint _epoch;
+  atomic_long _nbQuery[2];
+  // Background calibration, null if there is none
+  PTPEBackground* _background;
+  // Function called when the calibration improves and its user data,
+  // null to display the improvements on stdout
+  PTPEProgress _progress;
+  void* _progressData;
 } PixelToPosEstimator;
 
+// Packed set of correspondences between screen and real positions
+// The real positions are on the ground plane, their y coordinate is
+// not stored
+typedef struct PTPEDataset {
+  // Number of correspondences
+  long _nb;
+  // Number of correspondences the arrays can contain
+  long _capacity;
+  // Screen positions
+  float* _pxX;
+  float* _pxY;
+  // Real positions
+  float* _meterX;
+  float* _meterZ;
+  // Flag to memorize if the arrays are owned by another object (e.g.
+  // a memory mapped PTPEInput), they are then copied before being
+  // grown and are not freed with the data set
+  bool _isView;
+} PTPEDataset;
+
+// Input of the calibration: camera, image dimensions, bounds of the
+// point of view, and the correspondences used for the calibration and
+// for the test of its result
+typedef struct PTPEInput {
+  // Camera position
+  VecFloat3D _cameraPos;
+  // Dimension of the image
+  VecFloat2D _imgSize;
+  // Bounds of the point of view
+  VecFloat3D _POVmin;
+  VecFloat3D _POVmax;
+  // Correspondences for the calibration and for the test
+  PTPEDataset* _input;
+  PTPEDataset* _test;
+  // Memory containing the binary file the correspondences are read
+  // from, null if the input has been read from a text file
+  void* _data;
+  size_t _size;
+} PTPEInput;
+
+// Lookup table of the real positions for every pixel of the image
+typedef struct PTPELut {
+  // Number of nodes along x and y (dimensions of the image + 1), the
+  // node (i, j) is the screen position (i, j)
+  long _nbNodeX;
+  long _nbNodeY;
+  // Real positions (x, z) of the nodes, row by row
+  const float* _meter;
+  // Memory containing the table as saved on disk (header and nodes)
+  void* _data;
+  size_t _size;
+  // Flag to memorize if '_data' is memory mapped
+  bool _isMapped;
+} PTPELut;
+
+// Plane/ellipse model of the projection, for wide angle cameras
+// The real positions on the ground are expressed in polar coordinates
+// (theta, dist) around the camera's ground position, theta being the
+// angle from the direction of the point of view
+// They are projected on the screen at:
+// x = Ox + Sx * dist * sin(theta)
+// y = Oy - Sy * Ry(dist) * cos(theta)
+// Ry(dist) = f * (tan(theta0) - tan(theta0 - atan(dist / h)))
+// where h is the height of the camera and (theta0, f, Sx, Sy, Ox, Oy)
+// the projection parameters
+typedef struct PTPEEllipse {
+  // Camera position
+  VecFloat3D _cameraPos;
+  // Dimension of the image
+  VecFloat2D _imgSize;
+  // Position of the point of view on the ground
+  VecFloat3D _povPos;
+  // Projection parameters
+  // (theta0, f, Sx, Sy, Ox, Oy)
+  VecFloat* _param;
+} PTPEEllipse;
+
+// Read only mapping of a shared memory segment published by
+// PTPEShmPublish
+typedef struct PTPEShm {
+  // Mapped segment (header and grid)
+  void* _data;
+  size_t _size;
+  // Lookup table using the grid of the segment without copy, its
+  // number of nodes is 0 if the segment has no grid
+  PTPELut _lut;
+} PTPEShm;
+
 // ================ Functions declaration ====================
 
 // Create a new PixelToPosEstimator
@@ -51,6 +352,160 @@ PixelToPosEstimator PixelToPosEstimatorCreateStatic(
 // Free memory used by the PixelToPosEstimator 'that'
 void PixelToPosEstimatorFreeStatic(PixelToPosEstimator* that);
 
+// Compile the projection of the estimator 'that' from its current
+// projection parameters and camera position
+// Must be called again if '_cameraPos' or '_imgSize' are modified
+// Modifications of '_param' are detected automatically, the
+// conversions then fall back to the non compiled (slower) projection
+// until the next call to PTPECompile
+void PTPECompile(PixelToPosEstimator* const that);
+
+// Return true if the compiled projection of the estimator 'that' is
+// up to date with its projection parameters, false else
+bool PTPEIsCompiled(const PixelToPosEstimator* const that);
+
+// Set the projection parameters of the estimator 'that' to 'param'
+// and compile the projection
+void PTPESetParam(PixelToPosEstimator* const that,
+  const VecFloat* const param);
+
+// Load the projection parameters of the estimator 'that' from the
+// 'stream' and compile the projection
+// Return true if the parameters could be loaded, false else
+bool PTPELoadParam(PixelToPosEstimator* const that, FILE* const stream);
+
+// Set the number of threads used by PTPEInit to evaluate the
+// population of the estimator 'that' to 'nbThread' (1 by default)
+// The calibration gives the same result whatever the number of threads
+void PTPESetNbThread(PixelToPosEstimator* const that,
+  const int nbThread);
+
+// Get the number of threads used by PTPEInit to evaluate the
+// population of the estimator 'that'
+int PTPEGetNbThread(const PixelToPosEstimator* const that);
+
+// Create a compiled projection from the camera position 'cameraPos',
+// the image dimensions 'imgSize' and the projection parameters 'param'
+PTPEProj PTPEProjCreateStatic(const VecFloat3D* const cameraPos,
+  const VecFloat2D* const imgSize, const VecFloat* const param);
+
+// Convert the screen position to a real position with the compiled
+// projection 'that'
+VecFloat3D PTPEProjGetPxToMeter(const PTPEProj* const that,
+  const VecFloat2D* const screenPos);
+
+// Convert the screen position to a real position with the projection
+// parameters 'param' instead of those of the estimator 'that'
+// Only the camera position and image dimensions of 'that' are used,
+// 'that' is not modified
+VecFloat3D PTPEGetPxToMeterWithParam(
+  const PixelToPosEstimator* const that, const VecFloat* const param,
+  const VecFloat2D* const screenPos);
+
+// Return the average distance between the real positions 'posMeter'
+// and the real positions estimated from the screen positions
+// 'posPixel' with the projection parameters 'param'
+// Only the camera position and image dimensions of 'that' are used,
+// 'that' is not modified, so several threads can evaluate parameters
+// concurrently while the estimator is used
+float PTPEEvaluateParam(const PixelToPosEstimator* const that,
+  const VecFloat* const param, const GSet* const posMeter,
+  const GSet* const posPixel);
+
+// Return the average distance between the real positions and the real
+// positions estimated from the screen positions of the data set
+// 'dataset' with the projection parameters 'param', or HUGE_VAL if
+// the parameters are degenerated and the distance is not a number
+// Only the camera position and image dimensions of 'that' are used,
+// 'that' is not modified
+float PTPEEvaluateParamDataset(const PixelToPosEstimator* const that,
+  const VecFloat* const param, const PTPEDataset* const dataset);
+
+// Same as PTPEEvaluateParamDataset but the evaluation stops as soon as
+// the average distance is known to be greater than 'cutoff'
+// If the evaluation stops, 'isRejected' is set to true and the
+// returned value is a lower bound of the average distance, else
+// 'isRejected' is set to false and the returned value is the same as
+// PTPEEvaluateParamDataset
+// 'isRejected' can be null
+float PTPEEvaluateParamDatasetBounded(
+  const PixelToPosEstimator* const that, const VecFloat* const param, 
+  const PTPEDataset* const dataset, const float cutoff,
+  bool* const isRejected);
+
+// Create a new empty PTPEDataset able to contain 'capacity'
+// correspondences without reallocation
+PTPEDataset* PTPEDatasetCreate(const long capacity);
+
+// Create a new PTPEDataset from the real positions 'posMeter'
+// (VecFloat3D) and the screen positions 'posPixel' (VecFloat2D)
+PTPEDataset* PTPEDatasetCreateFromGSet(const GSet* const posMeter,
+  const GSet* const posPixel);
+
+// Free memory used by the PTPEDataset 'that'
+void PTPEDatasetFree(PTPEDataset** that);
+
+// Add the correspondence between the screen position ('pxX', 'pxY')
+// and the real position ('meterX', 0.0, 'meterZ') to the PTPEDataset
+// 'that'
+void PTPEDatasetAdd(PTPEDataset* const that, const float pxX,
+  const float pxY, const float meterX, const float meterZ);
+
+// Remove the correspondence at index 'iPos' from the PTPEDataset
+// 'that', the following correspondences keep their order
+void PTPEDatasetRemove(PTPEDataset* const that, const long iPos);
+
+// Get the number of correspondences in the PTPEDataset 'that'
+long PTPEDatasetGetNb(const PTPEDataset* const that);
+
+// Create a synthetic PTPEDataset of 'nb' correspondences with the
+// projection of the estimator 'that' as ground truth
+// The screen positions are drawn uniformly over the pixels of the
+// image viewing the ground within 'maxDist' meters of the camera,
+// their real positions are given by the projection, then a gaussian
+// noise of standard deviation 'noise' pixels is added to the screen
+// positions
+// A ratio 'outlierRatio' of the correspondences are outliers, their
+// screen position is drawn uniformly over the image independently of
+// their real position
+// 'seed' is the state of the random number generator (cf rand_r)
+// Return NULL if the image doesn't view enough of the ground (cf
+// PTPE_SYNTHETIC_NBMAXTRY)
+PTPEDataset* PTPEDatasetCreateSynthetic(
+  const PixelToPosEstimator* const that, const long nb,
+  const float noise, const float outlierRatio, const float maxDist,
+  unsigned int* const seed);
+
+// Read the input of the calibration from the text file 'stream': the
+// camera position, image dimensions, POVmin and POVmax as vectors
+// (cf VecLoad), then the number of correspondences for the calibration
+// followed by the real (VecFloat3D) and screen (VecFloat2D) positions
+// of each of them, and the same for the test
+// Return NULL if the file is invalid
+PTPEInput* PTPEInputLoadText(FILE* const stream);
+
+// Write the input of the calibration 'that' into the text file
+// 'stream' (cf PTPEInputLoadText)
+// Return true if the input could be written, false else
+bool PTPEInputSaveText(const PTPEInput* const that, FILE* const stream);
+
+// Save the input of the calibration 'that' into the binary file at
+// 'path': a header with the camera position, image dimensions and
+// bounds, followed by the packed and aligned arrays of the screen
+// and real positions of the calibration and test data sets
+// The file uses the byte order of the machine
+// Return true if the input could be saved, false else
+bool PTPEInputSave(const PTPEInput* const that, const char* const path);
+
+// Memory map the binary input file at 'path' (cf PTPEInputSave), the
+// data sets use the mapped arrays without copy
+// Return NULL if the file can't be mapped or isn't a valid binary
+// input file
+PTPEInput* PTPEInputLoad(const char* const path);
+
+// Free memory used by the input of the calibration 'that'
+void PTPEInputFree(PTPEInput** that);
+
 // Convert the screen position to a polar position
 VecFloat2D PTPEGetPxToPolar(
   const PixelToPosEstimator* const that, 
@@ -60,12 +515,235 @@ VecFloat2D PTPEGetPxToPolar(
 // 'nbEpoch' epochs or until the average error gets below 'prec'
 // Search for the parameters Px, Py, Pz in the bounding box defined
 // by POVmin-POVmax
+// With the PTPEModel5DOF model (cf PTPESetModel), the yaw and pitch are
+// searched in the range of directions from the camera to the bounding
+// box
 // the random generator must be initialized before calling this function
-void PTPEInit(PixelToPosEstimator* const that,
+// The projection is compiled at the end of the calibration
+// If the refine flag is set (cf PTPESetFlagRefine) the best adn is
+// refined with PTPERefine
+// With several islands (cf PTPESetNbIsland), each island has its own
+// population and random number generator, the best adn of each island
+// replaces the worst adn of the next one every migration period (cf
+// PTPESetMigrationPeriod) and the best adn over all the islands is
+// kept
+// The calibration stops early or restarts if it stagnates according
+// to the settings of the estimator (cf PTPESetStagnation)
+// Return the reason of the end of the calibration
+// The adns unchanged since the previous epoch (elites) are not
+// evaluated again, and the evaluation of the other adns stops as soon
+// as they can't be better than these elites (cf PTPEGetInitStat)
+// The correspondences are packed in a PTPEDataset before calibration
+PTPEStopReason PTPEInit(PixelToPosEstimator* const that,
   const GSet* const posMeter, const GSet* const posPixel, 
   const unsigned int nbEpoch, const float prec,
   const VecFloat3D* const POVmin, const VecFloat3D* const POVmax);
 
+// Same as PTPEInit with the correspondences given as a PTPEDataset
+PTPEStopReason PTPEInitDataset(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset,
+  const unsigned int nbEpoch, const float prec,
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax);
+
+// Same as PTPEInitDataset but the calibration also stops when
+// 'timeBudget' seconds have elapsed (if 'timeBudget' > 0) or when
+// 'cancel' is set to true (if 'cancel' is not null), both checked
+// between two epochs
+// The projection parameters are always set to the best ones found so
+// far, and their average error is available in the statistics (cf
+// PTPEGetInitStat)
+// The refinement (cf PTPESetFlagRefine) is skipped if the calibration
+// is cancelled or has used its time budget, else it stops at the end
+// of the time budget, so the calibration returns within the budget
+// plus one epoch
+PTPEStopReason PTPEInitDatasetBudget(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset,
+  const unsigned int nbEpoch, const float prec,
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax,
+  const double timeBudget, const atomic_bool* const cancel);
+
+// Set the number of islands of the calibration by PTPEInit for the
+// estimator 'that' to 'nbIsland' (1 by default)
+void PTPESetNbIsland(PixelToPosEstimator* const that,
+  const int nbIsland);
+
+// Get the number of islands of the calibration by PTPEInit for the
+// estimator 'that'
+int PTPEGetNbIsland(const PixelToPosEstimator* const that);
+
+// Set the number of epochs between two migrations of the best adns
+// between islands in PTPEInit for the estimator 'that' to 'period'
+// (PTPE_MIGRATIONPERIOD by default, 0 for no migration)
+void PTPESetMigrationPeriod(PixelToPosEstimator* const that,
+  const unsigned int period);
+
+// Get the number of epochs between two migrations of the best adns
+// between islands in PTPEInit for the estimator 'that'
+unsigned int PTPEGetMigrationPeriod(
+  const PixelToPosEstimator* const that);
+
+// Set the policy of the estimator 'that' when PTPEInit stagnates to
+// 'policy'
+// PTPEInit stagnates when the relative improvement of its best value
+// over the last 'window' epochs is below 'minImprovement', or the
+// diversity of its populations (cf PTPEInitStat) is below
+// 'minDiversity'
+void PTPESetStagnation(PixelToPosEstimator* const that,
+  const PTPEStagnationPolicy policy, const unsigned int window,
+  const float minImprovement, const float minDiversity);
+
+// Get the settings of the estimator 'that' when PTPEInit stagnates
+const PTPEStagnation* PTPEGetStagnation(
+  const PixelToPosEstimator* const that);
+
+// Set the function called by PTPEInit for the estimator 'that' each
+// time the calibration improves to 'progress', with the user data
+// 'data'
+// The function is called on the thread running the calibration
+// If 'progress' is null (default) the improvements are displayed on
+// stdout
+void PTPESetProgress(PixelToPosEstimator* const that,
+  const PTPEProgress progress, void* const data);
+
+// Return a description of the reason 'reason' of the end of PTPEInit
+const char* PTPEStopReasonToStr(const PTPEStopReason reason);
+
+// Get the statistics of the last calibration by PTPEInit of the
+// estimator 'that'
+const PTPEInitStat* PTPEGetInitStat(
+  const PixelToPosEstimator* const that);
+
+// Get the ratio of evaluations avoided by the cache of the statistics
+// 'that'
+float PTPEInitStatGetCacheHitRate(const PTPEInitStat* const that);
+
+// Return the current time in seconds of the monotonic clock
+double PTPEGetTime(void);
+
+// Recalibrate the estimator 'that' from its current projection
+// parameters with the correspondences of the data set 'dataset'
+// The genetic algorithm searches the 5 degrees of freedom (cf
+// PTPEParam5DOFToParam) around the current parameters, within
+// 'radius' (in radians) for the yaw, pitch and roll and within
+// 'radiusScale' (relative to their value) for Sx and Sy, then again
+// around the best parameters found with half the radii, and so on for
+// PTPE_RECALIBNBSTAGE stages
+// Each stage lasts at most 'nbEpoch' / PTPE_RECALIBNBSTAGE epochs and
+// stops earlier if it stagnates (cf PTPESetStagnation) or if the
+// average error gets below 'prec'
+// The projection parameters are updated only if the average error
+// decreases, and refined if the refine flag is set
+// Return the reason of the end of the recalibration
+PTPEStopReason PTPERecalibrate(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const unsigned int nbEpoch, 
+  const float prec, const float radius, const float radiusScale);
+
+// Start the calibration of the estimator 'that' on a background
+// thread, with the same arguments as PTPEInitDataset
+// The calibration runs on a copy of the estimator and of 'dataset',
+// 'dataset' can be freed as soon as this function returns
+// When the calibration ends, its compiled projection is published
+// atomically and used from then by the queries (PTPEGetPxToMeter,
+// PTPEGetPolarToMeter, PTPEGetPxToMeterBatch) which never block and
+// never see partially updated parameters
+// The estimator must not be modified, only queried, until
+// PTPEBackgroundJoin is called
+// From the start, the queries use an immutable copy of the current
+// compiled projection, then the published one which stays in use
+// after PTPEBackgroundJoin, so queries can run during successive
+// background calibrations, until the estimator is compiled again (cf
+// PTPECompile)
+// PTPEBackgroundJoin and PTPECompile wait for the end of the queries
+// which may be using the projections they modify or free
+void PTPEBackgroundStart(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset,
+  const unsigned int nbEpoch, const float prec,
+  const VecFloat3D* const POVmin, const VecFloat3D* const POVmax);
+
+// Return true if the background calibration of the estimator 'that'
+// has ended (or if there is none), false else
+bool PTPEBackgroundIsDone(const PixelToPosEstimator* const that);
+
+// Request the cancellation of the background calibration of the
+// estimator 'that', the current projection is then kept
+void PTPEBackgroundCancel(PixelToPosEstimator* const that);
+
+// Wait for the end of the background calibration of the estimator
+// 'that' and copy its parameters and statistics into 'that'
+// Return the reason of the end of the background calibration
+PTPEStopReason PTPEBackgroundJoin(PixelToPosEstimator* const that);
+
+// Set the flag to refine the result of the genetic algorithm in
+// PTPEInit with PTPERefine for the estimator 'that' to 'flag' (false
+// by default)
+void PTPESetFlagRefine(PixelToPosEstimator* const that, 
+  const bool flag);
+
+// Get the flag to refine the result of the genetic algorithm in
+// PTPEInit for the estimator 'that'
+bool PTPEGetFlagRefine(const PixelToPosEstimator* const that);
+
+// Set the model of the parameters searched by PTPEInit for the
+// estimator 'that' to 'model' (PTPEModelPOV by default)
+void PTPESetModel(PixelToPosEstimator* const that, 
+  const PTPEModel model);
+
+// Get the model of the parameters searched by PTPEInit for the
+// estimator 'that'
+PTPEModel PTPEGetModel(const PixelToPosEstimator* const that);
+
+// Convert the parameters 'param5DOF' of the 5 degrees of freedom model
+// (yaw, pitch, roll, Sx, Sy) into the projection parameters 'param'
+// for the camera of the estimator 'that'
+// The view direction is (cos(pitch)sin(yaw), sin(pitch),
+// cos(pitch)cos(yaw)), the POV is at 1m from the camera in this
+// direction, and Up is the vertical orthogonalised relative to the
+// view direction and rotated by roll around it
+void PTPEParam5DOFToParam(const PixelToPosEstimator* const that,
+  const VecFloat* const param5DOF, VecFloat* const param);
+
+// Convert the projection parameters 'param' into the parameters
+// 'param5DOF' of the 5 degrees of freedom model (yaw, pitch, roll, Sx,
+// Sy) for the camera of the estimator 'that'
+// The conversion is exact if Up is orthogonal to the view direction,
+// else only the component of Up orthogonal to the view direction is
+// kept
+void PTPEParamToParam5DOF(const PixelToPosEstimator* const that,
+  const VecFloat* const param, VecFloat* const param5DOF);
+
+// Refine the current projection parameters of the estimator 'that'
+// with the Levenberg-Marquardt algorithm minimizing the sum of the
+// squared distances between the real positions and the estimated
+// positions of the data set 'dataset', using the analytic jacobian of
+// the projection relative to the 8 parameters
+// Stops after 'nbMaxIter' iterations or when the improvement stalls
+// The parameters are updated only if the average error decreases
+// Return the average error after refinement
+float PTPERefine(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset, const int nbMaxIter);
+
+// Calculate the homography from the screen positions to the real
+// positions on the ground plane (y = 0) with the normalized direct
+// linear transformation, as an alternative to PTPEInit when the
+// ground is planar
+// Needs at least 4 correspondences, no 3 of them aligned
+// Return true if the homography could be calculated, false else
+bool PTPEInitHomography(PixelToPosEstimator* const that,
+  const GSet* const posMeter, const GSet* const posPixel);
+
+// Same as PTPEInitHomography with the correspondences given as a
+// PTPEDataset
+bool PTPEInitHomographyDataset(PixelToPosEstimator* const that,
+  const PTPEDataset* const dataset);
+
+// Convert the screen position 'screenPos' to the real position
+// 'realPos' with the homography calculated by PTPEInitHomography
+// Return false if the screen position is on the horizon line of the
+// homography ('realPos' is then set to NaN), true else
+bool PTPEGetPxToMeterHomography(
+  const PixelToPosEstimator* const that,
+  const VecFloat2D* const screenPos, VecFloat3D* const realPos);
+
 // Convert the screen position to a real position
 VecFloat3D PTPEGetPxToMeter(
   const PixelToPosEstimator* const that, 
@@ -76,4 +754,177 @@ VecFloat3D PTPEGetPolarToMeter(
   const PixelToPosEstimator* const that, 
   const VecFloat2D* const polarPos);
   
+// Convert the 'nb' screen positions ('pxX[i]', 'pxY[i]') to real
+// positions ('meterX[i]', 'meterZ[i]') on the ground plane (y = 0)
+// The arrays are not required to be aligned and must not overlap
+// Uses AVX (8 points per instruction) or SSE2 (4 points per
+// instruction) if enabled at compilation (cf SIMD_ARG in the Makefile),
+// else a scalar loop
+// Results are equal to those of PTPEGetPxToMeter within a relative
+// error of 1e-4 of the distance from the camera
+void PTPEGetPxToMeterBatch(const PixelToPosEstimator* const that,
+  const long nb, const float* const pxX, const float* const pxY,
+  float* const meterX, float* const meterZ);
+
+// Same as PTPEGetPxToMeterBatch with the compiled projection 'that'
+void PTPEProjGetPxToMeterBatch(const PTPEProj* const that,
+  const long nb, const float* const pxX, const float* const pxY,
+  float* const meterX, float* const meterZ);
+
+// Convert the real position 'realPos' on the ground plane to the
+// screen position 'screenPos', inverse of PTPEGetPxToMeter
+// The screen position may be outside the image
+// Return false if the real position is behind the camera or beyond
+// the horizon of the projection ('screenPos' is then set to NaN), true
+// else
+bool PTPEGetMeterToPx(const PixelToPosEstimator* const that,
+  const VecFloat3D* const realPos, VecFloat2D* const screenPos);
+
+// Convert the 'nb' real positions ('meterX[i]', 0.0, 'meterZ[i]') to
+// screen positions ('pxX[i]', 'pxY[i]'), inverse of
+// PTPEGetPxToMeterBatch
+// 'isValid[i]' is set to false if the real position is behind the
+// camera or beyond the horizon of the projection (the screen position
+// is then set to NaN), true else
+// The arrays are not required to be aligned and must not overlap
+// Uses AVX or SSE2 if enabled at compilation, else a scalar loop
+void PTPEGetMeterToPxBatch(const PixelToPosEstimator* const that,
+  const long nb, const float* const meterX, const float* const meterZ,
+  float* const pxX, float* const pxY, bool* const isValid);
+
+// Same as PTPEGetMeterToPxBatch with the compiled projection 'that'
+void PTPEProjGetMeterToPxBatch(const PTPEProj* const that,
+  const long nb, const float* const meterX, const float* const meterZ,
+  float* const pxX, float* const pxY, bool* const isValid);
+
+// Create the lookup table of the real position of every pixel of the
+// image for the estimator 'that'
+PTPELut* PTPELutCreate(const PixelToPosEstimator* const that);
+
+// Free memory used by the lookup table 'that'
+void PTPELutFree(PTPELut** that);
+
+// Save the lookup table 'that' into the binary file at 'path'
+// Return true if the table could be saved, false else
+bool PTPELutSave(const PTPELut* const that, const char* const path);
+
+// Memory map the lookup table saved at 'path'
+// Return NULL if the file can't be mapped, or if it hasn't been
+// created from the same camera position, image dimensions and
+// projection parameters as the estimator 'that'
+PTPELut* PTPELutLoad(const PixelToPosEstimator* const that,
+  const char* const path);
+
+// Convert the screen position to a real position using the lookup
+// table 'that', with bilinear interpolation between the pixels
+// Screen positions outside the image are clamped to the image
+VecFloat3D PTPELutGetPxToMeter(const PTPELut* const that,
+  const VecFloat2D* const screenPos);
+
+// Publish the camera position, image dimensions and projection
+// parameters of the estimator 'that' into the POSIX shared memory
+// segment 'name' (e.g. "/ptpe"), with the grid of the lookup table
+// (cf PTPELutCreate) if 'withGrid' is true
+// The segment is updated in place under its sequence counter (cf
+// PTPEShmBeginRead), if its size changes it is marked as stale and
+// replaced by a new segment of the same name (cf PTPEShmIsStale)
+// There must be only one publisher per segment at a time
+// Return true if the segment could be published, false else
+bool PTPEShmPublish(const PixelToPosEstimator* const that,
+  const char* const name, const bool withGrid);
+
+// Map read only the shared memory segment 'name' published by
+// PTPEShmPublish
+// Return NULL if the segment can't be mapped or is invalid
+PTPEShm* PTPEShmOpen(const char* const name);
+
+// Unmap the shared memory segment 'that'
+void PTPEShmClose(PTPEShm** that);
+
+// Return true if the shared memory segment 'that' has been replaced
+// by a new one, it must then be closed and opened again
+bool PTPEShmIsStale(const PTPEShm* const that);
+
+// Wait for the end of the current publication in the shared memory
+// segment 'that' and return its sequence counter
+// The values read from the segment (grid included) after this call
+// are consistent if PTPEShmEndRead returns true for the returned
+// counter, else they must be read again
+uint32_t PTPEShmBeginRead(const PTPEShm* const that);
+
+// Return true if the shared memory segment 'that' hasn't been
+// published again since PTPEShmBeginRead returned 'seq'
+bool PTPEShmEndRead(const PTPEShm* const that, const uint32_t seq);
+
+// Get the lookup table of the grid of the shared memory segment
+// 'that', it has no node if the segment has been published without
+// grid
+const PTPELut* PTPEShmGetLut(const PTPEShm* const that);
+
+// Create the estimator 'estimator' with the camera position, image
+// dimensions and projection parameters of the shared memory segment
+// 'that', compiled and ready to use without recalibration
+// Return the sequence counter of the values read
+uint32_t PTPEShmGetEstimator(const PTPEShm* const that,
+  PixelToPosEstimator* const estimator);
+
+// Create a new PTPEEllipse for the camera at 'posCamera', the image of
+// dimensions 'imgSize' and the point of view at 'povPos'
+PTPEEllipse PTPEEllipseCreateStatic(
+  const VecFloat3D* const posCamera, const VecFloat2D* const imgSize,
+  const VecFloat3D* const povPos);
+
+// Free memory used by the PTPEEllipse 'that'
+void PTPEEllipseFreeStatic(PTPEEllipse* const that);
+
+// Set the projection parameters of the PTPEEllipse 'that' to 'param'
+void PTPEEllipseSetParam(PTPEEllipse* const that,
+  const VecFloat* const param);
+
+// Calculate the projection parameters of the PTPEEllipse 'that' with
+// the correspondences of the data set 'dataset', with a genetic
+// algorithm minimizing the average distance in pixels between their
+// screen positions and the projection of their real positions
+// Stops after 'nbEpoch' epochs or when the average distance gets
+// below 'prec'
+// Return the average distance of the resulting parameters
+float PTPEEllipseInitDataset(PTPEEllipse* const that,
+  const PTPEDataset* const dataset, const unsigned int nbEpoch,
+  const float prec);
+
+// Convert the real position 'realPos' to a polar position
+// (theta, dist) for the PTPEEllipse 'that'
+// theta in [-PI,PI], dist in meter
+VecFloat2D PTPEEllipseGetMeterToPolar(const PTPEEllipse* const that,
+  const VecFloat3D* const realPos);
+
+// Convert the polar position 'polarPos' (theta, dist) to a real
+// position for the PTPEEllipse 'that'
+VecFloat3D PTPEEllipseGetPolarToMeter(const PTPEEllipse* const that,
+  const VecFloat2D* const polarPos);
+
+// Convert the polar position 'polarPos' (theta, dist) to a screen
+// position for the PTPEEllipse 'that'
+VecFloat2D PTPEEllipseGetPolarToPx(const PTPEEllipse* const that,
+  const VecFloat2D* const polarPos);
+
+// Convert the screen position 'screenPos' to the polar position
+// 'polarPos' (theta in [-PI/2,PI/2], dist) for the PTPEEllipse 'that'
+// by inversion of PTPEEllipseGetPolarToPx: the distance is the root
+// of an equation increasing on the distances where the projection is
+// defined, solved with Newton iterations safeguarded by bisection,
+// then theta is deduced from the x coordinate
+// Return false if the screen position has no antecedent in front of
+// the camera within PTPE_ELLIPSE_MAXDIST meters ('polarPos' is then
+// set to the nearest one), true else
+bool PTPEEllipseGetPxToPolar(const PTPEEllipse* const that,
+  const VecFloat2D* const screenPos, VecFloat2D* const polarPos);
+
+// Convert the screen position 'screenPos' to the real position
+// 'realPos' for the PTPEEllipse 'that' (cf PTPEEllipseGetPxToPolar)
+// Return false if the screen position has no antecedent in front of
+// the camera ('realPos' is then set to the nearest one), true else
+bool PTPEEllipseGetPxToMeter(const PTPEEllipse* const that,
+  const VecFloat2D* const screenPos, VecFloat3D* const realPos);
+
 #endif
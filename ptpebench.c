@@ -0,0 +1,373 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pixeltoposestimator.h"
+
+// Micro-benchmark of the projection hot path: measures the time per
+// point and the throughput of the conversion functions over random
+// screen positions of a 1280x720 frame, on one thread and on all the
+// cores, and reports them as a table, CSV or JSON
+
+// Dimensions of the frame
+#define BENCH_WIDTH 1280.0
+#define BENCH_HEIGHT 720.0
+
+// Default number of points and of repetitions of each measure
+#define BENCH_NBPOINT 1048576
+#define BENCH_NBREP 5
+
+// Format of the results
+typedef enum BenchFormat {
+  BenchFormatTable,
+  BenchFormatCSV,
+  BenchFormatJSON
+} BenchFormat;
+
+// Points the kernels are measured on
+typedef struct BenchPoints {
+  // Name of the distribution of the points
+  const char* _name;
+  // Number of points
+  long _nb;
+  // Screen positions
+  float* _pxX;
+  float* _pxY;
+  // Polar positions of the screen positions
+  VecFloat2D* _polar;
+  // Real positions of the screen positions
+  float* _meterX;
+  float* _meterZ;
+  // Output of the kernels
+  float* _outX;
+  float* _outY;
+  bool* _isValid;
+} BenchPoints;
+
+// Kernel converting the points of index 'from' to 'to' - 1 of 'points'
+// with the estimator 'estimator', returning a checksum of the results
+// to keep the compiler from discarding the conversions
+typedef float (*BenchKernel)(const PixelToPosEstimator* const estimator,
+  BenchPoints* const points, const long from, const long to);
+
+// Arguments of one thread of a measure
+typedef struct BenchJob {
+  const PixelToPosEstimator* _estimator;
+  BenchPoints* _points;
+  BenchKernel _kernel;
+  long _from;
+  long _to;
+  pthread_barrier_t* _barrier;
+  float _checksum;
+  // Time of the start and the end of the conversions
+  double _start;
+  double _end;
+} BenchJob;
+
+// Checksum of all the measures
+static volatile float benchSink = 0.0;
+
+// Kernel of PTPEGetPxToPolar
+static float KernelPxToPolar(const PixelToPosEstimator* const estimator,
+  BenchPoints* const points, const long from, const long to) {
+  float checksum = 0.0;
+  VecFloat2D screenPos = VecFloatCreateStatic2D();
+  for (long iPos = from; iPos < to; ++iPos) {
+    VecSet(&screenPos, 0, points->_pxX[iPos]);
+    VecSet(&screenPos, 1, points->_pxY[iPos]);
+    VecFloat2D polarPos = PTPEGetPxToPolar(estimator, &screenPos);
+    checksum += VecGet(&polarPos, 0) + VecGet(&polarPos, 1);
+  }
+  return checksum;
+}
+
+// Kernel of PTPEGetPolarToMeter
+static float KernelPolarToMeter(
+  const PixelToPosEstimator* const estimator,
+  BenchPoints* const points, const long from, const long to) {
+  float checksum = 0.0;
+  for (long iPos = from; iPos < to; ++iPos) {
+    VecFloat3D realPos =
+      PTPEGetPolarToMeter(estimator, points->_polar + iPos);
+    checksum += VecGet(&realPos, 0) + VecGet(&realPos, 2);
+  }
+  return checksum;
+}
+
+// Kernel of PTPEGetPxToMeter
+static float KernelPxToMeter(const PixelToPosEstimator* const estimator,
+  BenchPoints* const points, const long from, const long to) {
+  float checksum = 0.0;
+  VecFloat2D screenPos = VecFloatCreateStatic2D();
+  for (long iPos = from; iPos < to; ++iPos) {
+    VecSet(&screenPos, 0, points->_pxX[iPos]);
+    VecSet(&screenPos, 1, points->_pxY[iPos]);
+    VecFloat3D realPos = PTPEGetPxToMeter(estimator, &screenPos);
+    checksum += VecGet(&realPos, 0) + VecGet(&realPos, 2);
+  }
+  return checksum;
+}
+
+// Kernel of PTPEGetPxToMeterBatch
+static float KernelPxToMeterBatch(
+  const PixelToPosEstimator* const estimator,
+  BenchPoints* const points, const long from, const long to) {
+  PTPEGetPxToMeterBatch(estimator, to - from, points->_pxX + from,
+    points->_pxY + from, points->_outX + from, points->_outY + from);
+  return points->_outX[from] + points->_outY[to - 1];
+}
+
+// Kernel of PTPEGetMeterToPxBatch
+static float KernelMeterToPxBatch(
+  const PixelToPosEstimator* const estimator,
+  BenchPoints* const points, const long from, const long to) {
+  PTPEGetMeterToPxBatch(estimator, to - from, points->_meterX + from,
+    points->_meterZ + from, points->_outX + from, points->_outY + from,
+    points->_isValid + from);
+  return points->_outX[from] + points->_outY[to - 1];
+}
+
+// Main function of the thread of the job 'arg' (BenchJob*)
+static void* JobMain(void* arg) {
+  BenchJob* that = (BenchJob*)arg;
+  pthread_barrier_wait(that->_barrier);
+  that->_start = PTPEGetTime();
+  that->_checksum =
+    that->_kernel(that->_estimator, that->_points, that->_from, that->_to);
+  that->_end = PTPEGetTime();
+  return NULL;
+}
+
+// Measure the kernel 'kernel' on the points 'points' with 'nbThread'
+// threads, 'nbRep' times
+// Return the best duration in seconds
+static double Measure(const PixelToPosEstimator* const estimator,
+  BenchPoints* const points, const BenchKernel kernel,
+  const int nbThread, const int nbRep) {
+  double best = -1.0;
+  BenchJob* jobs = malloc(sizeof(BenchJob) * nbThread);
+  pthread_t* threads = malloc(sizeof(pthread_t) * nbThread);
+  for (int iRep = 0; iRep < nbRep; ++iRep) {
+    double elapsed = 0.0;
+    if (nbThread == 1) {
+      double start = PTPEGetTime();
+      benchSink += kernel(estimator, points, 0, points->_nb);
+      elapsed = PTPEGetTime() - start;
+    } else {
+      // The threads are released together by the barrier to exclude
+      // their creation, the measure spans from the first start to the
+      // last end of the threads
+      pthread_barrier_t barrier;
+      pthread_barrier_init(&barrier, NULL, nbThread);
+      for (int iThread = 0; iThread < nbThread; ++iThread) {
+        jobs[iThread]._estimator = estimator;
+        jobs[iThread]._points = points;
+        jobs[iThread]._kernel = kernel;
+        jobs[iThread]._from = points->_nb * iThread / nbThread;
+        jobs[iThread]._to = points->_nb * (iThread + 1) / nbThread;
+        jobs[iThread]._barrier = &barrier;
+        pthread_create(threads + iThread, NULL, JobMain, jobs + iThread);
+      }
+      double start = -1.0;
+      double end = -1.0;
+      for (int iThread = 0; iThread < nbThread; ++iThread) {
+        pthread_join(threads[iThread], NULL);
+        benchSink += jobs[iThread]._checksum;
+        if (start < 0.0 || jobs[iThread]._start < start)
+          start = jobs[iThread]._start;
+        if (jobs[iThread]._end > end)
+          end = jobs[iThread]._end;
+      }
+      elapsed = end - start;
+      pthread_barrier_destroy(&barrier);
+    }
+    if (best < 0.0 || elapsed < best)
+      best = elapsed;
+  }
+  free(threads);
+  free(jobs);
+  return best;
+}
+
+// Create the 'nb' points 'points' of the distribution 'name' for the
+// estimator 'estimator': uniform over the frame ("frame"), or uniform
+// over the pixels of the frame viewing the ground ("ground")
+// Return false if the frame doesn't view enough of the ground (at most
+// PTPE_SYNTHETIC_NBMAXTRY screen positions are drawn per point), true
+// else
+static bool BenchPointsCreate(BenchPoints* const that,
+  const char* const name, const long nb,
+  const PixelToPosEstimator* const estimator) {
+  BenchPoints points;
+  points._name = name;
+  points._nb = nb;
+  points._pxX = malloc(sizeof(float) * nb);
+  points._pxY = malloc(sizeof(float) * nb);
+  points._polar = malloc(sizeof(VecFloat2D) * nb);
+  points._meterX = malloc(sizeof(float) * nb);
+  points._meterZ = malloc(sizeof(float) * nb);
+  points._outX = malloc(sizeof(float) * nb);
+  points._outY = malloc(sizeof(float) * nb);
+  points._isValid = malloc(sizeof(bool) * nb);
+  bool isGround = (strcmp(name, "ground") == 0);
+  unsigned int seed = 1;
+  int nbTry = 0;
+  for (long iPos = 0; iPos < nb;) {
+    VecFloat2D screenPos = VecFloatCreateStatic2D();
+    VecSet(&screenPos, 0,
+      BENCH_WIDTH * (float)rand_r(&seed) / (float)RAND_MAX);
+    VecSet(&screenPos, 1,
+      BENCH_HEIGHT * (float)rand_r(&seed) / (float)RAND_MAX);
+    VecFloat3D realPos = PTPEGetPxToMeter(estimator, &screenPos);
+    if (isGround) {
+      VecFloat2D check = VecFloatCreateStatic2D();
+      if (!PTPEGetMeterToPx(estimator, &realPos, &check)) {
+        if (++nbTry == PTPE_SYNTHETIC_NBMAXTRY) {
+          *that = points;
+          return false;
+        }
+        continue;
+      }
+    }
+    nbTry = 0;
+    points._pxX[iPos] = VecGet(&screenPos, 0);
+    points._pxY[iPos] = VecGet(&screenPos, 1);
+    points._polar[iPos] = PTPEGetPxToPolar(estimator, &screenPos);
+    points._meterX[iPos] = VecGet(&realPos, 0);
+    points._meterZ[iPos] = VecGet(&realPos, 2);
+    ++iPos;
+  }
+  *that = points;
+  return true;
+}
+
+// Free the memory used by the points 'that'
+static void BenchPointsFree(BenchPoints* const that) {
+  free(that->_pxX);
+  free(that->_pxY);
+  free(that->_polar);
+  free(that->_meterX);
+  free(that->_meterZ);
+  free(that->_outX);
+  free(that->_outY);
+  free(that->_isValid);
+}
+
+int main(int argc, char** argv) {
+  // Default values of the arguments
+  BenchFormat format = BenchFormatTable;
+  const char* pathParam = NULL;
+  long nb = BENCH_NBPOINT;
+  int nbRep = BENCH_NBREP;
+  int nbThread = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  for (int iArg = 1; iArg < argc; ++iArg) {
+    if (strcmp(argv[iArg], "-csv") == 0) {
+      format = BenchFormatCSV;
+    } else if (strcmp(argv[iArg], "-json") == 0) {
+      format = BenchFormatJSON;
+    } else if (strcmp(argv[iArg], "-param") == 0 && iArg + 1 < argc) {
+      pathParam = argv[++iArg];
+    } else if (strcmp(argv[iArg], "-nb") == 0 && iArg + 1 < argc) {
+      nb = atol(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-rep") == 0 && iArg + 1 < argc) {
+      nbRep = atoi(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-thread") == 0 && iArg + 1 < argc) {
+      nbThread = atoi(argv[++iArg]);
+    } else {
+      fprintf(stderr, "Usage: ptpebench [-csv|-json] [-param <file>] "
+        "[-nb <nbPoint>] [-rep <nbRep>] [-thread <nbThread>]\n");
+      exit(0);
+    }
+  }
+  if (nb < 1 || nbRep < 1 || nbThread < 1) {
+    fprintf(stderr, "Invalid arguments\n");
+    exit(1);
+  }
+
+  // Create the estimator, with the projection parameters of the
+  // example of main by default
+  VecFloat3D posCamera = VecFloatCreateStatic3D();
+  VecSet(&posCamera, 1, 10.0);
+  VecFloat2D imgSize = VecFloatCreateStatic2D();
+  VecSet(&imgSize, 0, BENCH_WIDTH);
+  VecSet(&imgSize, 1, BENCH_HEIGHT);
+  PixelToPosEstimator estimator =
+    PixelToPosEstimatorCreateStatic(&posCamera, &imgSize);
+  if (pathParam != NULL) {
+    FILE* stream = fopen(pathParam, "r");
+    if (stream == NULL || !PTPELoadParam(&estimator, stream)) {
+      fprintf(stderr, "Can't load the parameters from %s\n", pathParam);
+      exit(1);
+    }
+    fclose(stream);
+  } else {
+    float param[PTPE_NBPARAM] = {8.661727, 8.266581, 8.676446,
+      0.849234, -0.323168, 0.143216, 0.941986, 0.170057};
+    for (int iParam = PTPE_NBPARAM; iParam--;)
+      VecSet(estimator._param, iParam, param[iParam]);
+    PTPECompile(&estimator);
+  }
+
+  // Kernels and distributions of points
+  const char* names[] = {"PTPEGetPxToPolar", "PTPEGetPolarToMeter",
+    "PTPEGetPxToMeter", "PTPEGetPxToMeterBatch",
+    "PTPEGetMeterToPxBatch"};
+  BenchKernel kernels[] = {KernelPxToPolar, KernelPolarToMeter,
+    KernelPxToMeter, KernelPxToMeterBatch, KernelMeterToPxBatch};
+  int nbKernel = sizeof(kernels) / sizeof(BenchKernel);
+  BenchPoints points[2];
+  if (!BenchPointsCreate(points, "frame", nb, &estimator) ||
+    !BenchPointsCreate(points + 1, "ground", nb, &estimator)) {
+    fprintf(stderr, "The frame doesn't view the ground\n");
+    exit(1);
+  }
+  int nbThreads[2] = {1, nbThread};
+  int nbConfig = (nbThread > 1 ? 2 : 1);
+
+  // Run the measures and display the results
+  if (format == BenchFormatCSV)
+    printf("kernel,distribution,threads,points,ns_per_point,"
+      "points_per_s\n");
+  else if (format == BenchFormatJSON)
+    printf("[\n");
+  else
+    printf("%-24s %-8s %7s %12s %14s\n", "kernel", "dist", "threads",
+      "ns/point", "points/s");
+  bool isFirst = true;
+  for (int iKernel = 0; iKernel < nbKernel; ++iKernel)
+    for (int iPoints = 0; iPoints < 2; ++iPoints)
+      for (int iConfig = 0; iConfig < nbConfig; ++iConfig) {
+        double elapsed = Measure(&estimator, points + iPoints,
+          kernels[iKernel], nbThreads[iConfig], nbRep);
+        double nsPerPoint = 1e9 * elapsed / (double)nb;
+        double pointsPerSec = (double)nb / elapsed;
+        if (format == BenchFormatCSV) {
+          printf("%s,%s,%d,%ld,%.3f,%.0f\n", names[iKernel],
+            points[iPoints]._name, nbThreads[iConfig], nb, nsPerPoint,
+            pointsPerSec);
+        } else if (format == BenchFormatJSON) {
+          printf("%s  {\"kernel\": \"%s\", \"distribution\": \"%s\", "
+            "\"threads\": %d, \"points\": %ld, \"ns_per_point\": %.3f, "
+            "\"points_per_s\": %.0f}", (isFirst ? "" : ",\n"),
+            names[iKernel], points[iPoints]._name, nbThreads[iConfig],
+            nb, nsPerPoint, pointsPerSec);
+        } else {
+          printf("%-24s %-8s %7d %12.3f %14.0f\n", names[iKernel],
+            points[iPoints]._name, nbThreads[iConfig], nsPerPoint,
+            pointsPerSec);
+        }
+        fflush(stdout);
+        isFirst = false;
+      }
+  if (format == BenchFormatJSON)
+    printf("\n]\n");
+
+  // Free memory
+  for (int iPoints = 2; iPoints--;)
+    BenchPointsFree(points + iPoints);
+  PixelToPosEstimatorFreeStatic(&estimator);
+
+  // Return success code
+  return 0;
+}
@@ -0,0 +1,425 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "pixeltoposestimator.h"
+
+// Benchmark of the time to accuracy of the calibration: synthetic
+// scenes with known ground truth are calibrated by each calibrator,
+// for several sizes of data set and seeds, and the error versus wall
+// time, the time to reach the requested precision and the final
+// train and test errors are reported as a table, CSV or JSON
+
+// Dimensions of the image, position of the camera and bounds of the
+// point of view of the synthetic scenes (as in inputTest.txt)
+#define CALIB_WIDTH 1280.0
+#define CALIB_HEIGHT 720.0
+#define CALIB_CAMERAHEIGHT 10.0
+#define CALIB_POVMIN {0.0, 0.0, 0.0}
+#define CALIB_POVMAX {10.0, 15.0, 10.0}
+
+// Maximum distance from the camera of the synthetic correspondences
+#define CALIB_MAXDIST 100.0
+
+// Number of noise free correspondences of the test data sets
+#define CALIB_NBTEST 1000
+
+// Maximum number of sizes of data set
+#define CALIB_NBMAXSIZE 16
+
+// Drift of the parameters the recalibration starts from relative to
+// the ground truth, in radians for the yaw, pitch and roll and
+// relative for Sx and Sy, and search radii of the recalibration
+#define CALIB_DRIFT 0.03
+#define CALIB_RECALIBRADIUS 0.1
+
+// Format of the results
+typedef enum CalibFormat {
+  CalibFormatTable,
+  CalibFormatCSV,
+  CalibFormatJSON
+} CalibFormat;
+
+// Calibrators
+typedef enum Calibrator {
+  // Genetic algorithm (PTPEInitDatasetBudget)
+  CalibratorGA,
+  // Genetic algorithm followed by the refinement
+  CalibratorGARefine,
+  // Genetic algorithm on 4 islands
+  CalibratorGAIslands,
+  // Genetic algorithm on the 5 degrees of freedom model
+  CalibratorGA5DOF,
+  // Homography (PTPEInitHomographyDataset)
+  CalibratorHomography,
+  // Recalibration (PTPERecalibrate) followed by the refinement, from
+  // the ground truth drifted by CALIB_DRIFT, without time budget
+  CalibratorRecalibrate,
+  CalibratorNb
+} Calibrator;
+
+// Names of the calibrators
+static const char* calibratorNames[CalibratorNb] = {"ga", "ga+refine",
+  "ga-islands", "ga-5dof", "homography", "recalibrate"};
+
+// Point of the error versus wall time curve of a calibration
+typedef struct CurvePoint {
+  double _elapsed;
+  unsigned long _epoch;
+  float _err;
+} CurvePoint;
+
+// Error versus wall time curve of a calibration
+typedef struct Curve {
+  CurvePoint* _points;
+  long _nb;
+  long _capacity;
+} Curve;
+
+// Result of one calibration
+typedef struct Run {
+  Calibrator _calibrator;
+  long _size;
+  unsigned int _seed;
+  // Time in seconds to reach the requested precision, negative if it
+  // hasn't been reached
+  double _timeToPrec;
+  // Duration in seconds and number of epochs of the calibration
+  double _elapsed;
+  unsigned long _nbEpoch;
+  // Average error in meters on the train and test data sets
+  float _trainErr;
+  float _testErr;
+  // Reason of the end of the calibration
+  const char* _stopReason;
+} Run;
+
+// Progress function of the calibration appending the improvements to
+// the curve 'data' (Curve*)
+static void CurveAppend(const float err, const unsigned long epoch,
+  const double elapsed, void* const data) {
+  Curve* that = (Curve*)data;
+  if (that->_nb == that->_capacity) {
+    that->_capacity = (that->_capacity == 0 ? 64 : 2 * that->_capacity);
+    that->_points =
+      realloc(that->_points, sizeof(CurvePoint) * that->_capacity);
+  }
+  that->_points[that->_nb]._elapsed = elapsed;
+  that->_points[that->_nb]._epoch = epoch;
+  that->_points[that->_nb]._err = err;
+  ++(that->_nb);
+}
+
+// Return the average distance in meters between the real positions of
+// the data set 'dataset' and those estimated from its screen positions
+// by the estimator 'estimator', with its homography if 'isHomography'
+static float GetErr(const PixelToPosEstimator* const estimator,
+  const PTPEDataset* const dataset, const bool isHomography) {
+  double err = 0.0;
+  VecFloat2D screenPos = VecFloatCreateStatic2D();
+  for (long iPos = 0; iPos < dataset->_nb; ++iPos) {
+    VecSet(&screenPos, 0, dataset->_pxX[iPos]);
+    VecSet(&screenPos, 1, dataset->_pxY[iPos]);
+    // A screen position on the horizon line of the homography is
+    // converted to NaN, which makes the error NaN
+    VecFloat3D realPos = VecFloatCreateStatic3D();
+    if (isHomography)
+      PTPEGetPxToMeterHomography(estimator, &screenPos, &realPos);
+    else
+      realPos = PTPEGetPxToMeter(estimator, &screenPos);
+    err += sqrt(fastpow(VecGet(&realPos, 0) - dataset->_meterX[iPos], 2) +
+      fastpow(VecGet(&realPos, 2) - dataset->_meterZ[iPos], 2));
+  }
+  return (float)(err / (double)(dataset->_nb));
+}
+
+// Set 'param' to the projection parameters of 'truth' drifted by
+// CALIB_DRIFT on each of the 5 degrees of freedom
+static void GetDrifted(const PixelToPosEstimator* const truth,
+  VecFloat* const param) {
+  VecFloat* param5DOF = VecFloatCreate(PTPE_NBPARAM5DOF);
+  PTPEParamToParam5DOF(truth, truth->_param, param5DOF);
+  for (int i = 0; i < PTPE_NBPARAM5DOF; ++i) {
+    float val = VecGet(param5DOF, i);
+    VecSet(param5DOF, i,
+      (i < 3 ? val + CALIB_DRIFT : val * (1.0 + CALIB_DRIFT)));
+  }
+  PTPEParam5DOFToParam(truth, param5DOF, param);
+  VecFree(&param5DOF);
+}
+
+// Calibrate an estimator for the camera 'posCamera' and image
+// 'imgSize' with the calibrator 'calibrator' on the data set 'train'
+// and evaluate it on the data set 'test'
+// The genetic algorithms run for at most 'nbEpoch' epochs and
+// 'timeBudget' seconds, or until the average error gets below 'prec'
+// The recalibration starts from the parameters 'drifted'
+static Run Calibrate(const Calibrator calibrator,
+  VecFloat3D* const posCamera, const VecFloat2D* const imgSize,
+  const VecFloat* const drifted,
+  const PTPEDataset* const train, const PTPEDataset* const test,
+  const unsigned int seed, const unsigned int nbEpoch, const float prec,
+  const double timeBudget, const int nbThread, Curve* const curve) {
+  Run run;
+  run._calibrator = calibrator;
+  run._size = train->_nb;
+  run._seed = seed;
+  run._nbEpoch = 0;
+  curve->_nb = 0;
+  PixelToPosEstimator estimator =
+    PixelToPosEstimatorCreateStatic(posCamera, imgSize);
+  PTPESetNbThread(&estimator, nbThread);
+  PTPESetProgress(&estimator, CurveAppend, curve);
+  bool isHomography = (calibrator == CalibratorHomography);
+  if (isHomography) {
+    double start = PTPEGetTime();
+    bool isOk = PTPEInitHomographyDataset(&estimator, train);
+    run._elapsed = PTPEGetTime() - start;
+    run._trainErr = GetErr(&estimator, train, true);
+    run._stopReason = (isOk ? "solved" : "failed");
+    CurveAppend(run._trainErr, 0, run._elapsed, curve);
+  } else {
+    if (calibrator == CalibratorGARefine)
+      PTPESetFlagRefine(&estimator, true);
+    else if (calibrator == CalibratorGAIslands)
+      PTPESetNbIsland(&estimator, 4);
+    else if (calibrator == CalibratorGA5DOF)
+      PTPESetModel(&estimator, PTPEModel5DOF);
+    float povMin[3] = CALIB_POVMIN;
+    float povMax[3] = CALIB_POVMAX;
+    VecFloat3D POVmin = VecFloatCreateStatic3D();
+    VecFloat3D POVmax = VecFloatCreateStatic3D();
+    for (int i = 3; i--;) {
+      VecSet(&POVmin, i, povMin[i]);
+      VecSet(&POVmax, i, povMax[i]);
+    }
+    srandom(seed);
+    PTPEStopReason stopReason;
+    if (calibrator == CalibratorRecalibrate) {
+      PTPESetFlagRefine(&estimator, true);
+      PTPESetParam(&estimator, drifted);
+      stopReason = PTPERecalibrate(&estimator, train, nbEpoch, prec,
+        CALIB_RECALIBRADIUS, CALIB_RECALIBRADIUS);
+    } else {
+      stopReason = PTPEInitDatasetBudget(&estimator, train, nbEpoch,
+        prec, &POVmin, &POVmax, timeBudget, NULL);
+    }
+    const PTPEInitStat* stat = PTPEGetInitStat(&estimator);
+    run._elapsed = stat->_elapsed;
+    run._nbEpoch = stat->_nbEpoch;
+    run._trainErr = stat->_bestErr;
+    run._stopReason = PTPEStopReasonToStr(stopReason);
+    // The refinement improves the error after the last epoch
+    if (curve->_nb == 0 ||
+      curve->_points[curve->_nb - 1]._err > run._trainErr)
+      CurveAppend(run._trainErr, run._nbEpoch, run._elapsed, curve);
+  }
+  run._testErr = GetErr(&estimator, test, isHomography);
+  run._timeToPrec = -1.0;
+  for (long iPoint = 0; iPoint < curve->_nb && run._timeToPrec < 0.0;
+    ++iPoint)
+    if (curve->_points[iPoint]._err <= prec)
+      run._timeToPrec = curve->_points[iPoint]._elapsed;
+  PixelToPosEstimatorFreeStatic(&estimator);
+  return run;
+}
+
+// Print the run 'run' and its curve 'curve' in the format 'format',
+// and its curve in CSV on 'streamCurve' if not null
+static void PrintRun(const Run* const run, const Curve* const curve,
+  const CalibFormat format, const bool isFirst, FILE* const streamCurve) {
+  const char* name = calibratorNames[run->_calibrator];
+  if (format == CalibFormatCSV) {
+    printf("%s,%ld,%u,%.6f,%.6f,%lu,%.6f,%.6f,%s\n", name, run->_size,
+      run->_seed, run->_timeToPrec, run->_elapsed, run->_nbEpoch,
+      run->_trainErr, run->_testErr, run->_stopReason);
+  } else if (format == CalibFormatJSON) {
+    printf("%s  {\"calibrator\": \"%s\", \"size\": %ld, \"seed\": %u, "
+      "\"time_to_prec\": %.6f, \"elapsed\": %.6f, \"epochs\": %lu, "
+      "\"train_err\": %.6f, \"test_err\": %.6f, \"stop\": \"%s\", "
+      "\"curve\": [", (isFirst ? "" : ",\n"), name, run->_size,
+      run->_seed, run->_timeToPrec, run->_elapsed, run->_nbEpoch,
+      run->_trainErr, run->_testErr, run->_stopReason);
+    for (long iPoint = 0; iPoint < curve->_nb; ++iPoint)
+      printf("%s[%.6f, %lu, %.6f]", (iPoint == 0 ? "" : ", "),
+        curve->_points[iPoint]._elapsed, curve->_points[iPoint]._epoch,
+        curve->_points[iPoint]._err);
+    printf("]}");
+  } else {
+    printf("%-11s %6ld %5u %12.3f %10.3f %8lu %10.4f %10.4f %s\n", name,
+      run->_size, run->_seed, run->_timeToPrec, run->_elapsed,
+      run->_nbEpoch, run->_trainErr, run->_testErr, run->_stopReason);
+  }
+  fflush(stdout);
+  if (streamCurve != NULL)
+    for (long iPoint = 0; iPoint < curve->_nb; ++iPoint)
+      fprintf(streamCurve, "%s,%ld,%u,%.6f,%lu,%.6f\n", name,
+        run->_size, run->_seed, curve->_points[iPoint]._elapsed,
+        curve->_points[iPoint]._epoch, curve->_points[iPoint]._err);
+}
+
+int main(int argc, char** argv) {
+  // Default values of the arguments
+  CalibFormat format = CalibFormatTable;
+  const char* pathParam = NULL;
+  const char* pathCurve = NULL;
+  long sizes[CALIB_NBMAXSIZE] = {10, 50, 200};
+  int nbSize = 3;
+  int nbSeed = 3;
+  float noise = 1.0;
+  float prec = 0.25;
+  unsigned int nbEpoch = 10000;
+  double timeBudget = 10.0;
+  int nbThread = 1;
+  bool isSelected[CalibratorNb];
+  for (int iCalib = CalibratorNb; iCalib--;)
+    isSelected[iCalib] = true;
+  for (int iArg = 1; iArg < argc; ++iArg) {
+    if (strcmp(argv[iArg], "-csv") == 0) {
+      format = CalibFormatCSV;
+    } else if (strcmp(argv[iArg], "-json") == 0) {
+      format = CalibFormatJSON;
+    } else if (strcmp(argv[iArg], "-param") == 0 && iArg + 1 < argc) {
+      pathParam = argv[++iArg];
+    } else if (strcmp(argv[iArg], "-curve") == 0 && iArg + 1 < argc) {
+      pathCurve = argv[++iArg];
+    } else if (strcmp(argv[iArg], "-size") == 0 && iArg + 1 < argc) {
+      // Comma separated list of sizes
+      char* ptr = argv[++iArg];
+      nbSize = 0;
+      while (*ptr != '\0' && nbSize < CALIB_NBMAXSIZE) {
+        sizes[nbSize++] = strtol(ptr, &ptr, 10);
+        if (*ptr == ',')
+          ++ptr;
+        else
+          break;
+      }
+    } else if (strcmp(argv[iArg], "-seed") == 0 && iArg + 1 < argc) {
+      nbSeed = atoi(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-noise") == 0 && iArg + 1 < argc) {
+      noise = atof(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-prec") == 0 && iArg + 1 < argc) {
+      prec = atof(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-epoch") == 0 && iArg + 1 < argc) {
+      nbEpoch = atoi(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-budget") == 0 && iArg + 1 < argc) {
+      timeBudget = atof(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-thread") == 0 && iArg + 1 < argc) {
+      nbThread = atoi(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-calib") == 0 && iArg + 1 < argc) {
+      // Comma separated list of calibrators
+      ++iArg;
+      for (int iCalib = CalibratorNb; iCalib--;) {
+        const char* ptr = strstr(argv[iArg], calibratorNames[iCalib]);
+        size_t len = strlen(calibratorNames[iCalib]);
+        isSelected[iCalib] = false;
+        while (ptr != NULL && !isSelected[iCalib]) {
+          isSelected[iCalib] = ((ptr == argv[iArg] || ptr[-1] == ',') &&
+            (ptr[len] == '\0' || ptr[len] == ','));
+          ptr = strstr(ptr + 1, calibratorNames[iCalib]);
+        }
+      }
+    } else {
+      fprintf(stderr, "Usage: ptpecalibbench [-csv|-json] "
+        "[-param <file>] [-curve <file>] [-size <n1,n2,...>] "
+        "[-seed <nbSeed>] [-noise <px>] [-prec <m>] [-epoch <nbEpoch>] "
+        "[-budget <s>] [-thread <nbThread>] "
+        "[-calib <ga,ga+refine,ga-islands,ga-5dof,homography,"
+        "recalibrate>]\n");
+      exit(0);
+    }
+  }
+  if (nbSize < 1 || nbSeed < 1 || noise < 0.0 || nbThread < 1) {
+    fprintf(stderr, "Invalid arguments\n");
+    exit(1);
+  }
+  for (int iSize = 0; iSize < nbSize; ++iSize)
+    if (sizes[iSize] < 4) {
+      fprintf(stderr, "The sizes must be at least 4\n");
+      exit(1);
+    }
+
+  // Ground truth, the projection parameters of the example of main by
+  // default
+  VecFloat3D posCamera = VecFloatCreateStatic3D();
+  VecSet(&posCamera, 1, CALIB_CAMERAHEIGHT);
+  VecFloat2D imgSize = VecFloatCreateStatic2D();
+  VecSet(&imgSize, 0, CALIB_WIDTH);
+  VecSet(&imgSize, 1, CALIB_HEIGHT);
+  PixelToPosEstimator truth =
+    PixelToPosEstimatorCreateStatic(&posCamera, &imgSize);
+  if (pathParam != NULL) {
+    FILE* stream = fopen(pathParam, "r");
+    if (stream == NULL || !PTPELoadParam(&truth, stream)) {
+      fprintf(stderr, "Can't load the parameters from %s\n", pathParam);
+      exit(1);
+    }
+    fclose(stream);
+  } else {
+    float param[PTPE_NBPARAM] = {8.661727, 8.266581, 8.676446,
+      0.849234, -0.323168, 0.143216, 0.941986, 0.170057};
+    for (int iParam = PTPE_NBPARAM; iParam--;)
+      VecSet(truth._param, iParam, param[iParam]);
+    PTPECompile(&truth);
+  }
+  VecFloat* drifted = VecFloatCreate(PTPE_NBPARAM);
+  GetDrifted(&truth, drifted);
+  FILE* streamCurve = NULL;
+  if (pathCurve != NULL) {
+    streamCurve = fopen(pathCurve, "w");
+    if (streamCurve == NULL) {
+      fprintf(stderr, "Can't open %s\n", pathCurve);
+      exit(1);
+    }
+    fprintf(streamCurve, "calibrator,size,seed,elapsed,epoch,err\n");
+  }
+
+  // Run the calibrations
+  if (format == CalibFormatCSV)
+    printf("calibrator,size,seed,time_to_prec,elapsed,epochs,"
+      "train_err,test_err,stop\n");
+  else if (format == CalibFormatJSON)
+    printf("[\n");
+  else
+    printf("%-11s %6s %5s %12s %10s %8s %10s %10s %s\n", "calibrator",
+      "size", "seed", "timeToPrec", "elapsed", "epochs", "trainErr",
+      "testErr", "stop");
+  Curve curve = {NULL, 0, 0};
+  bool isFirst = true;
+  for (int iSize = 0; iSize < nbSize; ++iSize) {
+    for (int iSeed = 1; iSeed <= nbSeed; ++iSeed) {
+      // Synthetic scene of this size and seed, the test data set is
+      // noise free
+      unsigned int seed = iSeed;
+      PTPEDataset* train = PTPEDatasetCreateSynthetic(&truth,
+        sizes[iSize], noise, 0.0, CALIB_MAXDIST, &seed);
+      PTPEDataset* test = PTPEDatasetCreateSynthetic(&truth,
+        CALIB_NBTEST, 0.0, 0.0, CALIB_MAXDIST, &seed);
+      if (train == NULL || test == NULL) {
+        fprintf(stderr, "The camera doesn't view the ground\n");
+        exit(1);
+      }
+      for (int iCalib = 0; iCalib < CalibratorNb; ++iCalib) {
+        if (!isSelected[iCalib])
+          continue;
+        Run run = Calibrate(iCalib, &posCamera, &imgSize, drifted, train,
+          test, iSeed, nbEpoch, prec, timeBudget, nbThread, &curve);
+        PrintRun(&run, &curve, format, isFirst, streamCurve);
+        isFirst = false;
+      }
+      PTPEDatasetFree(&train);
+      PTPEDatasetFree(&test);
+    }
+  }
+  if (format == CalibFormatJSON)
+    printf("\n]\n");
+
+  // Free memory
+  if (streamCurve != NULL)
+    fclose(streamCurve);
+  free(curve._points);
+  VecFree(&drifted);
+  PixelToPosEstimatorFreeStatic(&truth);
+
+  // Return success code
+  return 0;
+}
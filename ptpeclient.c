@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "pixeltoposestimator.h"
+#include "ptpeserver.h"
+
+// Benchmark of ptpeserver measuring the latency of the requests and
+// the throughput of the server with several concurrent connections
+
+// Arguments and results of one connection
+typedef struct Connection {
+  // Path of the socket and name of the camera
+  const char* _path;
+  const char* _camera;
+  // Number of requests and of positions per request
+  long _nbRequest;
+  long _nbPerRequest;
+  // Dimensions of the frame the screen positions are drawn in
+  float _width;
+  float _height;
+  // Seed of the random screen positions
+  unsigned int _seed;
+  // Latency of each request in seconds
+  double* _latencies;
+  // Flag to memorize if all the requests succeeded
+  bool _isOk;
+} Connection;
+
+// Send the 'size' bytes of 'buffer' on the socket 'fd'
+// Return true if they could be sent, false else
+static bool SendAll(const int fd, const char* buffer, size_t size) {
+  while (size > 0) {
+    ssize_t nb = send(fd, buffer, size, MSG_NOSIGNAL);
+    if (nb <= 0)
+      return false;
+    buffer += nb;
+    size -= nb;
+  }
+  return true;
+}
+
+// Receive 'size' bytes into 'buffer' from the socket 'fd'
+// Return true if they could be received, false else
+static bool RecvAll(const int fd, char* buffer, size_t size) {
+  while (size > 0) {
+    ssize_t nb = recv(fd, buffer, size, 0);
+    if (nb <= 0)
+      return false;
+    buffer += nb;
+    size -= nb;
+  }
+  return true;
+}
+
+// Main function of the thread of the connection 'arg' (Connection*)
+static void* ConnectionMain(void* arg) {
+  Connection* that = (Connection*)arg;
+  that->_isOk = false;
+  // Connect to the server
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, that->_path, sizeof(addr.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "Can't connect to %s\n", that->_path);
+    if (fd >= 0)
+      close(fd);
+    return NULL;
+  }
+  // Buffers of the request and the response
+  size_t sizePos = sizeof(float) * 2 * that->_nbPerRequest;
+  char* request = malloc(sizeof(PTPEServerRequest) + sizePos);
+  char* response = malloc(sizeof(PTPEServerResponse) + sizePos);
+  PTPEServerRequest header;
+  memset(&header, 0, sizeof(PTPEServerRequest));
+  header._magic = PTPESERVER_MAGIC;
+  header._nb = that->_nbPerRequest;
+  strncpy(header._camera, that->_camera, PTPESERVER_NAMELENGTH - 1);
+  memcpy(request, &header, sizeof(PTPEServerRequest));
+  float* px = (float*)(request + sizeof(PTPEServerRequest));
+  // Loop on the requests
+  bool isOk = true;
+  for (long iRequest = 0; isOk && iRequest < that->_nbRequest;
+    ++iRequest) {
+    for (long i = 0; i < that->_nbPerRequest; ++i) {
+      px[2 * i] =
+        that->_width * (float)rand_r(&(that->_seed)) / (float)RAND_MAX;
+      px[2 * i + 1] =
+        that->_height * (float)rand_r(&(that->_seed)) / (float)RAND_MAX;
+    }
+    double start = PTPEGetTime();
+    PTPEServerResponse status;
+    isOk = SendAll(fd, request, sizeof(PTPEServerRequest) + sizePos) &&
+      RecvAll(fd, response, sizeof(PTPEServerResponse));
+    if (isOk) {
+      memcpy(&status, response, sizeof(PTPEServerResponse));
+      isOk = (status._status == PTPEServerStatusOk &&
+        status._nb == header._nb) &&
+        RecvAll(fd, response + sizeof(PTPEServerResponse), sizePos);
+      if (!isOk)
+        fprintf(stderr, "Request failed (status %u)\n", status._status);
+    }
+    that->_latencies[iRequest] = PTPEGetTime() - start;
+  }
+  that->_isOk = isOk;
+  free(request);
+  free(response);
+  close(fd);
+  return NULL;
+}
+
+// Compare two doubles for qsort
+static int CmpDouble(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "Usage: ptpeclient <socket> <camera> "
+      "[nbConnection (4)] [nbRequest (1000)] [nbPerRequest (256)] "
+      "[width (1280)] [height (720)]\n");
+    exit(0);
+  }
+  int nbConnection = (argc > 3 ? atoi(argv[3]) : 4);
+  long nbRequest = (argc > 4 ? atol(argv[4]) : 1000);
+  long nbPerRequest = (argc > 5 ? atol(argv[5]) : 256);
+  float width = (argc > 6 ? atof(argv[6]) : 1280.0);
+  float height = (argc > 7 ? atof(argv[7]) : 720.0);
+  if (nbConnection < 1 || nbRequest < 1 || nbPerRequest < 1 ||
+    nbPerRequest > PTPESERVER_MAXNB || width <= 0.0 || height <= 0.0) {
+    fprintf(stderr, "Invalid arguments\n");
+    exit(0);
+  }
+
+  // Run the connections concurrently
+  Connection* connections = calloc(nbConnection, sizeof(Connection));
+  pthread_t* threads = calloc(nbConnection, sizeof(pthread_t));
+  double* latencies = malloc(sizeof(double) * nbConnection * nbRequest);
+  double start = PTPEGetTime();
+  for (int iConn = 0; iConn < nbConnection; ++iConn) {
+    connections[iConn]._path = argv[1];
+    connections[iConn]._camera = argv[2];
+    connections[iConn]._nbRequest = nbRequest;
+    connections[iConn]._nbPerRequest = nbPerRequest;
+    connections[iConn]._width = width;
+    connections[iConn]._height = height;
+    connections[iConn]._seed = iConn + 1;
+    connections[iConn]._latencies = latencies + iConn * nbRequest;
+    pthread_create(threads + iConn, NULL, ConnectionMain,
+      connections + iConn);
+  }
+  bool isOk = true;
+  for (int iConn = 0; iConn < nbConnection; ++iConn) {
+    pthread_join(threads[iConn], NULL);
+    isOk = isOk && connections[iConn]._isOk;
+  }
+  double elapsed = PTPEGetTime() - start;
+  if (!isOk) {
+    fprintf(stderr, "The benchmark failed\n");
+    exit(1);
+  }
+
+  // Display the results
+  long nb = nbConnection * nbRequest;
+  qsort(latencies, nb, sizeof(double), CmpDouble);
+  printf("Connections: %d, requests: %ld x %ld positions\n",
+    nbConnection, nbRequest, nbPerRequest);
+  printf("Latency (us): p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+    1e6 * latencies[nb / 2], 1e6 * latencies[nb * 9 / 10],
+    1e6 * latencies[nb * 99 / 100], 1e6 * latencies[nb - 1]);
+  printf("Throughput: %.0f requests/s, %.0f positions/s\n",
+    (double)nb / elapsed, (double)(nb * nbPerRequest) / elapsed);
+
+  // Free memory
+  free(latencies);
+  free(threads);
+  free(connections);
+
+  // Return success code
+  return 0;
+}
@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "pixeltoposestimator.h"
+
+// Generator of synthetic correspondences with known ground truth,
+// replacing the rendering of ground.pov: the screen positions viewing
+// the ground are projected to their real positions with given
+// projection parameters, then noise and outliers are added, and the
+// correspondences are written as a text input file (cf inputTest.txt)
+// and optionally as a binary input file (cf PTPEInputSave)
+
+// Default dimensions of the image, position of the camera and bounds
+// of the point of view (as in inputTest.txt)
+#define GEN_WIDTH 1280.0
+#define GEN_HEIGHT 720.0
+#define GEN_CAMERA {0.0, 10.0, 0.0}
+#define GEN_POVMIN {0.0, 0.0, 0.0}
+#define GEN_POVMAX {10.0, 15.0, 10.0}
+
+// Default maximum distance from the camera of the correspondences
+#define GEN_MAXDIST 100.0
+
+// Parse the 'dim' comma separated values of 'str' into 'val'
+// Return true if the values could be parsed, false else
+static bool ParseVal(const char* str, const int dim, float* const val) {
+  for (int i = 0; i < dim; ++i) {
+    char* end = NULL;
+    val[i] = strtof(str, &end);
+    if (end == str || (i < dim - 1 && *end != ','))
+      return false;
+    str = end + 1;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  // Default values of the arguments
+  const char* pathParam = NULL;
+  const char* pathText = NULL;
+  const char* pathBinary = NULL;
+  float camera[3] = GEN_CAMERA;
+  float img[2] = {GEN_WIDTH, GEN_HEIGHT};
+  float povMin[3] = GEN_POVMIN;
+  float povMax[3] = GEN_POVMAX;
+  long nbInput = 1000;
+  long nbTest = 100;
+  float noise = 0.0;
+  float outlierRatio = 0.0;
+  float maxDist = GEN_MAXDIST;
+  unsigned int seed = 1;
+  bool isOk = true;
+  for (int iArg = 1; isOk && iArg < argc; ++iArg) {
+    if (strcmp(argv[iArg], "-param") == 0 && iArg + 1 < argc) {
+      pathParam = argv[++iArg];
+    } else if (strcmp(argv[iArg], "-camera") == 0 && iArg + 1 < argc) {
+      isOk = ParseVal(argv[++iArg], 3, camera);
+    } else if (strcmp(argv[iArg], "-img") == 0 && iArg + 1 < argc) {
+      isOk = ParseVal(argv[++iArg], 2, img);
+    } else if (strcmp(argv[iArg], "-povmin") == 0 && iArg + 1 < argc) {
+      isOk = ParseVal(argv[++iArg], 3, povMin);
+    } else if (strcmp(argv[iArg], "-povmax") == 0 && iArg + 1 < argc) {
+      isOk = ParseVal(argv[++iArg], 3, povMax);
+    } else if (strcmp(argv[iArg], "-nb") == 0 && iArg + 1 < argc) {
+      nbInput = atol(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-test") == 0 && iArg + 1 < argc) {
+      nbTest = atol(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-noise") == 0 && iArg + 1 < argc) {
+      noise = atof(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-outlier") == 0 && iArg + 1 < argc) {
+      outlierRatio = atof(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-maxdist") == 0 && iArg + 1 < argc) {
+      maxDist = atof(argv[++iArg]);
+    } else if (strcmp(argv[iArg], "-seed") == 0 && iArg + 1 < argc) {
+      seed = atoi(argv[++iArg]);
+    } else if (argv[iArg][0] != '-' && pathText == NULL) {
+      pathText = argv[iArg];
+    } else if (argv[iArg][0] != '-' && pathBinary == NULL) {
+      pathBinary = argv[iArg];
+    } else {
+      isOk = false;
+    }
+  }
+  if (!isOk || pathText == NULL) {
+    fprintf(stderr, "Usage: ptpegen [-param <file>] [-camera <x,y,z>] "
+      "[-img <w,h>] [-povmin <x,y,z>] [-povmax <x,y,z>] [-nb <nb>] "
+      "[-test <nb>] [-noise <px>] [-outlier <ratio>] [-maxdist <m>] "
+      "[-seed <seed>] <text file> [binary file]\n");
+    exit(0);
+  }
+  if (nbInput < 1 || nbTest < 0 || noise < 0.0 || outlierRatio < 0.0 ||
+    outlierRatio > 1.0 || maxDist <= 0.0 || img[0] < 1.0 ||
+    img[1] < 1.0 || camera[1] <= 0.0) {
+    fprintf(stderr, "Invalid arguments\n");
+    exit(1);
+  }
+
+  // Ground truth, the projection parameters of the example of main by
+  // default
+  VecFloat3D posCamera = VecFloatCreateStatic3D();
+  VecFloat2D imgSize = VecFloatCreateStatic2D();
+  PTPEInput input;
+  input._cameraPos = VecFloatCreateStatic3D();
+  input._imgSize = VecFloatCreateStatic2D();
+  input._POVmin = VecFloatCreateStatic3D();
+  input._POVmax = VecFloatCreateStatic3D();
+  for (int i = 3; i--;) {
+    VecSet(&posCamera, i, camera[i]);
+    VecSet(&(input._cameraPos), i, camera[i]);
+    VecSet(&(input._POVmin), i, povMin[i]);
+    VecSet(&(input._POVmax), i, povMax[i]);
+  }
+  for (int i = 2; i--;) {
+    VecSet(&imgSize, i, img[i]);
+    VecSet(&(input._imgSize), i, img[i]);
+  }
+  PixelToPosEstimator truth =
+    PixelToPosEstimatorCreateStatic(&posCamera, &imgSize);
+  if (pathParam != NULL) {
+    FILE* stream = fopen(pathParam, "r");
+    if (stream == NULL || !PTPELoadParam(&truth, stream)) {
+      fprintf(stderr, "Can't load the parameters from %s\n", pathParam);
+      exit(1);
+    }
+    fclose(stream);
+  } else {
+    float param[PTPE_NBPARAM] = {8.661727, 8.266581, 8.676446,
+      0.849234, -0.323168, 0.143216, 0.941986, 0.170057};
+    for (int iParam = PTPE_NBPARAM; iParam--;)
+      VecSet(truth._param, iParam, param[iParam]);
+    PTPECompile(&truth);
+  }
+
+  // Generate the correspondences, the test ones are noise and outlier
+  // free
+  double start = PTPEGetTime();
+  input._input = PTPEDatasetCreateSynthetic(&truth, nbInput, noise,
+    outlierRatio, maxDist, &seed);
+  input._test = (input._input == NULL ? NULL :
+    PTPEDatasetCreateSynthetic(&truth, nbTest, 0.0, 0.0, maxDist, &seed));
+  input._data = NULL;
+  input._size = 0;
+  if (input._input == NULL || input._test == NULL) {
+    fprintf(stderr, "The image doesn't view the ground within %f m\n",
+      maxDist);
+    exit(1);
+  }
+  double elapsedGen = PTPEGetTime() - start;
+
+  // Write the input files
+  start = PTPEGetTime();
+  FILE* stream = fopen(pathText, "w");
+  if (stream == NULL || !PTPEInputSaveText(&input, stream)) {
+    fprintf(stderr, "Can't write %s\n", pathText);
+    exit(1);
+  }
+  fclose(stream);
+  if (pathBinary != NULL && !PTPEInputSave(&input, pathBinary)) {
+    fprintf(stderr, "Can't write %s\n", pathBinary);
+    exit(1);
+  }
+  double elapsedSave = PTPEGetTime() - start;
+  printf("Generated %ld + %ld correspondences in %.3fs "
+    "(%.0f per second), written in %.3fs\n", nbInput, nbTest,
+    elapsedGen, (double)(nbInput + nbTest) / elapsedGen, elapsedSave);
+
+  // Free memory
+  PTPEDatasetFree(&(input._input));
+  PTPEDatasetFree(&(input._test));
+  PixelToPosEstimatorFreeStatic(&truth);
+
+  // Return success code
+  return 0;
+}
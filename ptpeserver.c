@@ -0,0 +1,444 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "pixeltoposestimator.h"
+#include "ptpeserver.h"
+
+// Daemon converting the screen positions of named cameras to real
+// positions for the clients connected on a Unix domain socket (cf
+// ptpeserver.h for the protocol)
+// The requests received from all the clients during one iteration of
+// the event loop are coalesced per camera and converted with one call
+// to PTPEGetPxToMeterBatch
+
+// Maximum number of connected clients
+#define SERVER_MAXCLIENT 256
+
+// Size of the blocks read from the sockets
+#define SERVER_READSIZE 65536
+
+// Number of bytes waiting to be sent to a client above which its
+// requests are not read anymore until it reads its responses
+#define SERVER_MAXOUT (4 * 1024 * 1024)
+
+// Camera served by the daemon
+typedef struct Camera {
+  // Name of the camera
+  char _name[PTPESERVER_NAMELENGTH];
+  // Estimator of the camera
+  PixelToPosEstimator _estimator;
+  // Positions of the requests of the current iteration
+  long _nb;
+  long _capacity;
+  float* _pxX;
+  float* _pxY;
+  float* _meterX;
+  float* _meterZ;
+} Camera;
+
+// Client connected to the daemon
+typedef struct Client {
+  // Socket of the client, -1 if the slot is free
+  int _fd;
+  // Bytes received and not yet processed
+  char* _in;
+  size_t _inLen;
+  size_t _inCapacity;
+  // Bytes to send
+  char* _out;
+  size_t _outLen;
+  size_t _outPos;
+  size_t _outCapacity;
+  // Flag to close the connection once the bytes to send have been sent
+  bool _isClosing;
+  // Flag to memorize that the client has shut down its side of the
+  // connection, it is closed once the complete requests received have
+  // been answered
+  bool _isEOF;
+} Client;
+
+// Request of the current iteration waiting for its conversion
+typedef struct Pending {
+  // Client of the request
+  Client* _client;
+  // Status of the response
+  PTPEServerStatus _status;
+  // Camera of the request
+  Camera* _camera;
+  // Index of the first position of the request in the camera's
+  // positions and number of positions
+  long _from;
+  long _nb;
+} Pending;
+
+// Flag set by the signals stopping the daemon
+static volatile sig_atomic_t isStopping = 0;
+
+// Handler of the signals stopping the daemon
+static void OnSignal(int sig) {
+  (void)sig;
+  isStopping = 1;
+}
+
+// Grow the buffer 'buffer' of capacity 'capacity' to contain at least
+// 'size' bytes
+static void Reserve(char** const buffer, size_t* const capacity,
+  const size_t size) {
+  if (size <= *capacity)
+    return;
+  size_t cap = (*capacity < 1024 ? 1024 : *capacity);
+  while (cap < size)
+    cap *= 2;
+  *buffer = realloc(*buffer, cap);
+  if (*buffer == NULL) {
+    fprintf(stderr, "Can't allocate %zu bytes\n", cap);
+    exit(1);
+  }
+  *capacity = cap;
+}
+
+// Add the 'nb' positions stored as pairs of floats at 'px' to the
+// camera 'camera' and return the index of the first one
+static long CameraAdd(Camera* const camera, const long nb,
+  const char* const px) {
+  if (camera->_nb + nb > camera->_capacity) {
+    long cap = (camera->_capacity < 1024 ? 1024 : camera->_capacity);
+    while (cap < camera->_nb + nb)
+      cap *= 2;
+    float* block = malloc(sizeof(float) * 4 * cap);
+    if (block == NULL) {
+      fprintf(stderr, "Can't allocate %ld positions\n", cap);
+      exit(1);
+    }
+    memcpy(block, camera->_pxX, sizeof(float) * camera->_nb);
+    memcpy(block + cap, camera->_pxY, sizeof(float) * camera->_nb);
+    free(camera->_pxX);
+    camera->_pxX = block;
+    camera->_pxY = block + cap;
+    camera->_meterX = block + 2 * cap;
+    camera->_meterZ = block + 3 * cap;
+    camera->_capacity = cap;
+  }
+  long from = camera->_nb;
+  for (long i = 0; i < nb; ++i) {
+    const char* pair = px + sizeof(float) * 2 * i;
+    memcpy(camera->_pxX + from + i, pair, sizeof(float));
+    memcpy(camera->_pxY + from + i, pair + sizeof(float), sizeof(float));
+  }
+  camera->_nb += nb;
+  return from;
+}
+
+// Create the camera described by 'arg' ('name:input file:param file')
+// Return false if it can't be created
+static bool CameraCreate(Camera* const camera, char* const arg) {
+  char* name = strtok(arg, ":");
+  char* pathInput = strtok(NULL, ":");
+  char* pathParam = strtok(NULL, ":");
+  if (name == NULL || pathInput == NULL || pathParam == NULL ||
+    strlen(name) >= PTPESERVER_NAMELENGTH)
+    return false;
+  // Read the camera position and image dimensions from the input file
+  PTPEInput* input = PTPEInputLoad(pathInput);
+  if (input == NULL) {
+    FILE* stream = fopen(pathInput, "r");
+    if (stream == NULL)
+      return false;
+    input = PTPEInputLoadText(stream);
+    fclose(stream);
+    if (input == NULL)
+      return false;
+  }
+  memset(camera, 0, sizeof(Camera));
+  strcpy(camera->_name, name);
+  camera->_estimator = PixelToPosEstimatorCreateStatic(
+    &(input->_cameraPos), &(input->_imgSize));
+  PTPEInputFree(&input);
+  // Load the projection parameters
+  FILE* stream = fopen(pathParam, "r");
+  if (stream == NULL)
+    return false;
+  bool ret = PTPELoadParam(&(camera->_estimator), stream);
+  fclose(stream);
+  return ret;
+}
+
+// Close the connection with the client 'client'
+static void ClientClose(Client* const client) {
+  close(client->_fd);
+  free(client->_in);
+  free(client->_out);
+  memset(client, 0, sizeof(Client));
+  client->_fd = -1;
+}
+
+// Read the available bytes of the client 'client'
+// Return false if the connection has failed
+static bool ClientRead(Client* const client) {
+  while (!(client->_isEOF)) {
+    Reserve(&(client->_in), &(client->_inCapacity),
+      client->_inLen + SERVER_READSIZE);
+    ssize_t nb = recv(client->_fd, client->_in + client->_inLen,
+      SERVER_READSIZE, 0);
+    if (nb > 0)
+      client->_inLen += nb;
+    else if (nb == 0)
+      client->_isEOF = true;
+    else
+      return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+  }
+  return true;
+}
+
+// Send the pending bytes of the client 'client'
+// Return false if the connection has failed
+static bool ClientWrite(Client* const client) {
+  while (client->_outPos < client->_outLen) {
+    ssize_t nb = send(client->_fd, client->_out + client->_outPos,
+      client->_outLen - client->_outPos, MSG_NOSIGNAL);
+    if (nb < 0)
+      return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+    client->_outPos += nb;
+  }
+  client->_outPos = 0;
+  client->_outLen = 0;
+  return true;
+}
+
+// Append the response of status 'status' with the 'nb' positions
+// ('meterX[i]', 'meterZ[i]') to the bytes to send to the client
+// 'client'
+static void ClientRespond(Client* const client,
+  const PTPEServerStatus status, const long nb,
+  const float* const meterX, const float* const meterZ) {
+  PTPEServerResponse response;
+  response._status = status;
+  response._nb = (status == PTPEServerStatusOk ? nb : 0);
+  Reserve(&(client->_out), &(client->_outCapacity), client->_outLen +
+    sizeof(PTPEServerResponse) + sizeof(float) * 2 * response._nb);
+  char* ptr = client->_out + client->_outLen;
+  memcpy(ptr, &response, sizeof(PTPEServerResponse));
+  ptr += sizeof(PTPEServerResponse);
+  for (long i = 0; i < (long)(response._nb); ++i) {
+    memcpy(ptr, meterX + i, sizeof(float));
+    memcpy(ptr + sizeof(float), meterZ + i, sizeof(float));
+    ptr += 2 * sizeof(float);
+  }
+  client->_outLen = ptr - client->_out;
+}
+
+// Extract the complete requests of the client 'client' and append
+// them to 'pendings' with their positions added to the cameras
+// 'cameras'
+static void ClientParse(Client* const client, Camera* const cameras,
+  const int nbCamera, Pending** const pendings, long* const nbPending,
+  long* const capacityPending) {
+  size_t pos = 0;
+  while (!(client->_isClosing) &&
+    client->_inLen - pos >= sizeof(PTPEServerRequest)) {
+    PTPEServerRequest request;
+    memcpy(&request, client->_in + pos, sizeof(PTPEServerRequest));
+    // Get the pending slot
+    if (*nbPending == *capacityPending) {
+      *capacityPending = (*capacityPending < 64 ? 64 : 2 * *capacityPending);
+      *pendings = realloc(*pendings, sizeof(Pending) * *capacityPending);
+      if (*pendings == NULL) {
+        fprintf(stderr, "Can't allocate the pending requests\n");
+        exit(1);
+      }
+    }
+    Pending* pending = *pendings + *nbPending;
+    pending->_client = client;
+    pending->_status = PTPEServerStatusInvalid;
+    pending->_camera = NULL;
+    pending->_from = 0;
+    pending->_nb = 0;
+    // Invalid requests close the connection
+    if (request._magic != PTPESERVER_MAGIC ||
+      request._nb > PTPESERVER_MAXNB ||
+      memchr(request._camera, '\0', PTPESERVER_NAMELENGTH) == NULL) {
+      client->_isClosing = true;
+      ++(*nbPending);
+      break;
+    }
+    size_t size = sizeof(PTPEServerRequest) +
+      sizeof(float) * 2 * request._nb;
+    if (client->_inLen - pos < size)
+      break;
+    // Add the positions to the camera
+    for (int iCamera = nbCamera; iCamera--;)
+      if (strcmp(cameras[iCamera]._name, request._camera) == 0)
+        pending->_camera = cameras + iCamera;
+    pending->_status = PTPEServerStatusUnknownCamera;
+    if (pending->_camera != NULL) {
+      pending->_status = PTPEServerStatusOk;
+      pending->_nb = request._nb;
+      pending->_from = CameraAdd(pending->_camera, request._nb,
+        client->_in + pos + sizeof(PTPEServerRequest));
+    }
+    ++(*nbPending);
+    pos += size;
+  }
+  // Keep the incomplete request
+  client->_inLen -= pos;
+  memmove(client->_in, client->_in + pos, client->_inLen);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr,
+      "Usage: ptpeserver <socket> <name>:<input file>:<param file> ...\n");
+    exit(0);
+  }
+
+  // Create the cameras
+  int nbCamera = argc - 2;
+  Camera* cameras = calloc(nbCamera, sizeof(Camera));
+  for (int iCamera = 0; iCamera < nbCamera; ++iCamera) {
+    if (!CameraCreate(cameras + iCamera, argv[iCamera + 2])) {
+      fprintf(stderr, "Invalid camera %s\n", argv[iCamera + 2]);
+      exit(0);
+    }
+  }
+
+  // Create the socket
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(argv[1]) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Socket path too long %s\n", argv[1]);
+    exit(0);
+  }
+  strcpy(addr.sun_path, argv[1]);
+  int fdListen = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(argv[1]);
+  if (fdListen < 0 ||
+    bind(fdListen, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+    listen(fdListen, SERVER_MAXCLIENT) != 0) {
+    fprintf(stderr, "Can't listen on %s (%s)\n", argv[1],
+      strerror(errno));
+    exit(0);
+  }
+  fcntl(fdListen, F_SETFL, O_NONBLOCK);
+  signal(SIGINT, OnSignal);
+  signal(SIGTERM, OnSignal);
+  printf("Listening on %s\n", argv[1]);
+  fflush(stdout);
+
+  // Event loop
+  Client clients[SERVER_MAXCLIENT];
+  for (int iClient = SERVER_MAXCLIENT; iClient--;) {
+    memset(clients + iClient, 0, sizeof(Client));
+    clients[iClient]._fd = -1;
+  }
+  struct pollfd fds[SERVER_MAXCLIENT + 1];
+  Client* fdClients[SERVER_MAXCLIENT + 1];
+  Pending* pendings = NULL;
+  long capacityPending = 0;
+  while (!isStopping) {
+    // Wait for events on the listening socket and the clients
+    int nbFd = 0;
+    fds[nbFd].fd = fdListen;
+    fds[nbFd].events = POLLIN;
+    fdClients[nbFd++] = NULL;
+    for (int iClient = 0; iClient < SERVER_MAXCLIENT; ++iClient) {
+      if (clients[iClient]._fd < 0)
+        continue;
+      fds[nbFd].fd = clients[iClient]._fd;
+      // Stop reading the requests of a client which doesn't read its
+      // responses
+      bool isReading = !(clients[iClient]._isClosing ||
+        clients[iClient]._isEOF || clients[iClient]._outLen -
+        clients[iClient]._outPos > SERVER_MAXOUT);
+      fds[nbFd].events = (clients[iClient]._outLen > 0 ? POLLOUT : 0) |
+        (isReading ? POLLIN : 0);
+      fdClients[nbFd++] = clients + iClient;
+    }
+    if (poll(fds, nbFd, -1) < 0)
+      continue;
+    // Accept the new clients
+    if (fds[0].revents & POLLIN) {
+      int fd = -1;
+      while ((fd = accept(fdListen, NULL, NULL)) >= 0) {
+        int iClient = 0;
+        while (iClient < SERVER_MAXCLIENT && clients[iClient]._fd >= 0)
+          ++iClient;
+        if (iClient == SERVER_MAXCLIENT) {
+          close(fd);
+        } else {
+          fcntl(fd, F_SETFL, O_NONBLOCK);
+          clients[iClient]._fd = fd;
+        }
+      }
+    }
+    // Read the clients' requests and send their responses
+    for (int iFd = 1; iFd < nbFd; ++iFd) {
+      Client* client = fdClients[iFd];
+      bool isOpen = true;
+      if (fds[iFd].revents & (POLLIN | POLLHUP | POLLERR))
+        isOpen = ClientRead(client);
+      if (isOpen && (fds[iFd].revents & POLLOUT))
+        isOpen = ClientWrite(client);
+      if (!isOpen)
+        ClientClose(client);
+    }
+    // Coalesce the complete requests per camera
+    long nbPending = 0;
+    for (int iClient = 0; iClient < SERVER_MAXCLIENT; ++iClient)
+      if (clients[iClient]._fd >= 0)
+        ClientParse(clients + iClient, cameras, nbCamera, &pendings,
+          &nbPending, &capacityPending);
+    // Convert the positions of each camera in one batch
+    for (int iCamera = nbCamera; nbPending > 0 && iCamera--;) {
+      Camera* camera = cameras + iCamera;
+      if (camera->_nb > 0)
+        PTPEGetPxToMeterBatch(&(camera->_estimator), camera->_nb,
+          camera->_pxX, camera->_pxY, camera->_meterX, camera->_meterZ);
+    }
+    // Dispatch the results in the order of the requests
+    for (long iPending = 0; iPending < nbPending; ++iPending) {
+      Pending* pending = pendings + iPending;
+      if (pending->_status == PTPEServerStatusOk)
+        ClientRespond(pending->_client, pending->_status, pending->_nb,
+          pending->_camera->_meterX + pending->_from,
+          pending->_camera->_meterZ + pending->_from);
+      else
+        ClientRespond(pending->_client, pending->_status, 0, NULL, NULL);
+    }
+    for (int iCamera = nbCamera; iCamera--;)
+      cameras[iCamera]._nb = 0;
+    // Send the responses, the clients which have shut down their side
+    // or sent an invalid request are closed once all their complete
+    // requests have been answered
+    for (int iClient = 0; iClient < SERVER_MAXCLIENT; ++iClient) {
+      Client* client = clients + iClient;
+      if (client->_fd < 0)
+        continue;
+      bool isOpen = (client->_outLen == 0 || ClientWrite(client));
+      if (!isOpen || (client->_outLen == 0 &&
+        (client->_isClosing || client->_isEOF)))
+        ClientClose(client);
+    }
+  }
+
+  // Free memory
+  for (int iClient = SERVER_MAXCLIENT; iClient--;)
+    if (clients[iClient]._fd >= 0)
+      ClientClose(clients + iClient);
+  close(fdListen);
+  unlink(argv[1]);
+  for (int iCamera = nbCamera; iCamera--;) {
+    PixelToPosEstimatorFreeStatic(&(cameras[iCamera]._estimator));
+    free(cameras[iCamera]._pxX);
+  }
+  free(cameras);
+  free(pendings);
+
+  // Return success code
+  return 0;
+}
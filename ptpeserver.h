@@ -0,0 +1,60 @@
+// ============ PTPESERVER.H ================
+
+#ifndef PTPESERVER_H
+#define PTPESERVER_H
+
+// ================= Include =================
+
+#include <stdint.h>
+
+// ================= Define ==================
+
+// Protocol between ptpeserver and its clients over a Unix domain
+// socket, all values are in the byte order of the machine
+// A request is a PTPEServerRequest followed by '_nb' pairs of floats
+// (screen x, screen y), its response is a PTPEServerResponse followed,
+// if '_status' is PTPEServerStatusOk, by '_nb' pairs of floats (real
+// x, real z)
+// Requests on a connection are answered in order
+
+// Magic number of the requests
+#define PTPESERVER_MAGIC 0x45505450
+
+// Maximum length of the camera names, including the terminating null
+// character
+#define PTPESERVER_NAMELENGTH 32
+
+// Maximum number of positions in one request
+#define PTPESERVER_MAXNB 65536
+
+// ================= Data structure ===================
+
+// Status of the responses
+typedef enum PTPEServerStatus {
+  // The positions have been converted
+  PTPEServerStatusOk,
+  // The camera is unknown
+  PTPEServerStatusUnknownCamera,
+  // The request is invalid, the connection is closed
+  PTPEServerStatusInvalid
+} PTPEServerStatus;
+
+// Header of the requests
+typedef struct PTPEServerRequest {
+  // Magic number (PTPESERVER_MAGIC)
+  uint32_t _magic;
+  // Number of positions
+  uint32_t _nb;
+  // Name of the camera
+  char _camera[PTPESERVER_NAMELENGTH];
+} PTPEServerRequest;
+
+// Header of the responses
+typedef struct PTPEServerResponse {
+  // Status of the response (PTPEServerStatus)
+  uint32_t _status;
+  // Number of positions
+  uint32_t _nb;
+} PTPEServerResponse;
+
+#endif
@@ -0,0 +1,534 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <sched.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "pixeltoposestimator.h"
+
+// Checks of the library guarding against regressions, each check
+// displays its result and the executable returns a non null code if
+// one of them failed
+
+// Dimensions of the image and height of the camera of the checks (as
+// in inputTest.txt)
+#define TEST_WIDTH 1280.0
+#define TEST_HEIGHT 720.0
+#define TEST_CAMERAHEIGHT 10.0
+
+// Number of query threads, of background calibrations and of queried
+// screen positions of the check of the background calibration
+#define TEST_BG_NBTHREAD 4
+#define TEST_BG_NBCYCLE 3
+#define TEST_BG_NBPX 64
+
+// Maximum number of distinct results per screen position and per
+// background calibration seen by a query thread
+#define TEST_BG_NBMAXRES 4
+
+// Number of screen positions converted at once by the slow query of
+// the check of the background calibration (not a multiple of the SIMD
+// width so the projection is read again at the end of the conversion),
+// and duration in nanoseconds of its stall, longer than the time taken
+// by the calibration
+#define TEST_BG_NBSLOW 65539
+#define TEST_BG_STALL 300000000
+
+// Number of correspondences of the checks of the conversions, not a
+// multiple of the SIMD width so the scalar remainder is also checked,
+// and their maximum distance in meters from the camera
+#define TEST_CONV_NB 1001
+#define TEST_CONV_MAXDIST 100.0
+
+// Maximum error of PTPEGetPxToMeterBatch relative to the distance from
+// the camera (as documented), and maximum error in pixels of the
+// conversions from real positions to screen positions
+#define TEST_CONV_PRECMETER 1e-4
+#define TEST_CONV_PRECPX 1e-2
+
+// Maximum difference between the real positions given by two
+// homographies of the same correspondences, relative to the distance
+// from the camera
+#define TEST_HOM_PREC 1e-3
+
+// Create an estimator with the projection parameters of the example
+// of main, perturbed by 'delta' radians on the point of view
+static PixelToPosEstimator CreateEstimator(const float delta) {
+  VecFloat3D posCamera = VecFloatCreateStatic3D();
+  VecSet(&posCamera, 1, TEST_CAMERAHEIGHT);
+  VecFloat2D imgSize = VecFloatCreateStatic2D();
+  VecSet(&imgSize, 0, TEST_WIDTH);
+  VecSet(&imgSize, 1, TEST_HEIGHT);
+  PixelToPosEstimator estimator =
+    PixelToPosEstimatorCreateStatic(&posCamera, &imgSize);
+  float param[PTPE_NBPARAM] = {8.661727 + delta, 8.266581, 8.676446,
+    0.849234, -0.323168, 0.143216, 0.941986, 0.170057};
+  for (int iParam = PTPE_NBPARAM; iParam--;)
+    VecSet(estimator._param, iParam, param[iParam]);
+  PTPECompile(&estimator);
+  return estimator;
+}
+
+// Progress function of the calibrations, silent
+static void Silent(const float err, const unsigned long epoch,
+  const double elapsed, void* const data) {
+  (void)err;
+  (void)epoch;
+  (void)elapsed;
+  (void)data;
+}
+
+// Results of the queries of one thread during a background calibration
+typedef struct BgQuery {
+  // Estimator queried and flag to stop the queries
+  const PixelToPosEstimator* _estimator;
+  atomic_bool* _stop;
+  // Distinct results (x, z) per screen position
+  float _res[TEST_BG_NBPX][TEST_BG_NBMAXRES][2];
+  int _nbRes[TEST_BG_NBPX];
+  // Flag to memorize if more than TEST_BG_NBMAXRES distinct results
+  // have been seen for a screen position
+  bool _isOverflow;
+} BgQuery;
+
+// Return the screen position of index 'iPx' queried during the
+// background calibration, below the horizon
+static VecFloat2D BgGetPx(const int iPx) {
+  VecFloat2D screenPos = VecFloatCreateStatic2D();
+  VecSet(&screenPos, 0, TEST_WIDTH * (float)(iPx % 8) / 8.0);
+  VecSet(&screenPos, 1, TEST_HEIGHT * (float)(iPx / 8) / 16.0);
+  return screenPos;
+}
+
+// Main function of the query threads 'arg' (BgQuery*)
+static void* BgQueryMain(void* arg) {
+  BgQuery* that = (BgQuery*)arg;
+  while (!atomic_load(that->_stop)) {
+    for (int iPx = 0; iPx < TEST_BG_NBPX; ++iPx) {
+      VecFloat2D screenPos = BgGetPx(iPx);
+      VecFloat3D realPos = PTPEGetPxToMeter(that->_estimator, &screenPos);
+      float res[2] = {VecGet(&realPos, 0), VecGet(&realPos, 2)};
+      bool isNew = true;
+      for (int iRes = 0; isNew && iRes < that->_nbRes[iPx]; ++iRes)
+        isNew = (memcmp(that->_res[iPx][iRes], res, sizeof(res)) != 0);
+      if (isNew && that->_nbRes[iPx] == TEST_BG_NBMAXRES) {
+        that->_isOverflow = true;
+      } else if (isNew) {
+        memcpy(that->_res[iPx][that->_nbRes[iPx]], res, sizeof(res));
+        ++(that->_nbRes[iPx]);
+      }
+    }
+  }
+  return NULL;
+}
+
+// Return true if the results 'res' of the queries of the screen
+// position of index 'iPx' are those of the projection parameters of
+// one of the estimators 'estimators'
+static bool BgCheckRes(const float* const res, const int iPx,
+  const PixelToPosEstimator* const estimators, const int nbEstimator) {
+  VecFloat2D screenPos = BgGetPx(iPx);
+  for (int iEstimator = 0; iEstimator < nbEstimator; ++iEstimator) {
+    VecFloat3D realPos =
+      PTPEGetPxToMeter(estimators + iEstimator, &screenPos);
+    float expected[2] = {VecGet(&realPos, 0), VecGet(&realPos, 2)};
+    if (memcmp(expected, res, sizeof(expected)) == 0)
+      return true;
+  }
+  return false;
+}
+
+// Check that the queries running on several threads during
+// successive background calibrations always return the result of the
+// parameters before or after the calibration
+static bool CheckBackground(void) {
+  PixelToPosEstimator truth = CreateEstimator(0.0);
+  PixelToPosEstimator estimator = CreateEstimator(0.5);
+  PTPESetProgress(&estimator, Silent, NULL);
+  unsigned int seed = 1;
+  PTPEDataset* dataset = PTPEDatasetCreateSynthetic(&truth, 50, 0.0,
+    0.0, 100.0, &seed);
+  VecFloat3D POVmin = VecFloatCreateStatic3D();
+  VecFloat3D POVmax = VecFloatCreateStatic3D();
+  for (int i = 3; i--;)
+    VecSet(&POVmax, i, (i == 1 ? 15.0 : 10.0));
+  BgQuery* queries = calloc(TEST_BG_NBTHREAD, sizeof(BgQuery));
+  pthread_t threads[TEST_BG_NBTHREAD];
+  bool isOk = true;
+  srandom(1);
+  for (int iCycle = 0; isOk && iCycle < TEST_BG_NBCYCLE; ++iCycle) {
+    // Estimators with the parameters before and after the calibration
+    PixelToPosEstimator expected[2];
+    expected[0] = CreateEstimator(0.0);
+    PTPESetParam(expected, estimator._param);
+    // Query the estimator during the calibration
+    atomic_bool stop;
+    atomic_init(&stop, false);
+    memset(queries, 0, TEST_BG_NBTHREAD * sizeof(BgQuery));
+    for (int iThread = 0; iThread < TEST_BG_NBTHREAD; ++iThread) {
+      queries[iThread]._estimator = &estimator;
+      queries[iThread]._stop = &stop;
+      pthread_create(threads + iThread, NULL, BgQueryMain,
+        queries + iThread);
+    }
+    PTPEBackgroundStart(&estimator, dataset, 200, 0.0, &POVmin, &POVmax);
+    PTPEStopReason stopReason = PTPEBackgroundJoin(&estimator);
+    atomic_store(&stop, true);
+    for (int iThread = 0; iThread < TEST_BG_NBTHREAD; ++iThread)
+      pthread_join(threads[iThread], NULL);
+    expected[1] = CreateEstimator(0.0);
+    PTPESetParam(expected + 1, estimator._param);
+    // Check the results
+    isOk = (stopReason != PTPEStopReasonCancel);
+    for (int iThread = 0; isOk && iThread < TEST_BG_NBTHREAD; ++iThread) {
+      isOk = !(queries[iThread]._isOverflow);
+      for (int iPx = 0; isOk && iPx < TEST_BG_NBPX; ++iPx)
+        for (int iRes = 0; isOk && iRes < queries[iThread]._nbRes[iPx];
+          ++iRes)
+          isOk = BgCheckRes(queries[iThread]._res[iPx][iRes], iPx,
+            expected, 2);
+    }
+    PixelToPosEstimatorFreeStatic(expected);
+    PixelToPosEstimatorFreeStatic(expected + 1);
+  }
+  free(queries);
+  PTPEDatasetFree(&dataset);
+  PixelToPosEstimatorFreeStatic(&estimator);
+  PixelToPosEstimatorFreeStatic(&truth);
+  return isOk;
+}
+
+// Results of the slow queries during a background calibration
+typedef struct BgSlowQuery {
+  // Estimator queried and flag to stop the queries
+  const PixelToPosEstimator* _estimator;
+  atomic_bool* _stop;
+  // Number of queries done
+  atomic_long _nbQuery;
+  // Screen positions converted by the queries
+  const float* _pxX;
+  const float* _pxY;
+  // Real positions (x then z) of the parameters before the calibration
+  const float* _before;
+  // Real positions (x then z) of the last query and those of the first
+  // query whose results differ from '_before'
+  float* _meter;
+  float* _other;
+  // Flag to memorize if '_other' has been set, and if the results of a
+  // query differ from both '_before' and '_other'
+  bool _hasOther;
+  bool _isMixed;
+} BgSlowQuery;
+
+// Handler of the signal stalling the slow query thread, as if it was
+// preempted during TEST_BG_STALL nanoseconds
+static void BgStall(int sig) {
+  (void)sig;
+  struct timespec ts = {0, TEST_BG_STALL};
+  nanosleep(&ts, NULL);
+}
+
+// Main function of the slow query thread 'arg' (BgSlowQuery*)
+static void* BgSlowQueryMain(void* arg) {
+  BgSlowQuery* that = (BgSlowQuery*)arg;
+  size_t size = sizeof(float) * 2 * TEST_BG_NBSLOW;
+  while (!atomic_load(that->_stop)) {
+    PTPEGetPxToMeterBatch(that->_estimator, TEST_BG_NBSLOW, that->_pxX,
+      that->_pxY, that->_meter, that->_meter + TEST_BG_NBSLOW);
+    atomic_fetch_add(&(that->_nbQuery), 1);
+    if (memcmp(that->_meter, that->_before, size) == 0)
+      continue;
+    if (!(that->_hasOther)) {
+      memcpy(that->_other, that->_meter, size);
+      that->_hasOther = true;
+    } else if (memcmp(that->_meter, that->_other, size) != 0) {
+      that->_isMixed = true;
+    }
+  }
+  return NULL;
+}
+
+// Check that a query converting many positions at once, stalled during
+// the successive background calibrations, always uses the parameters
+// before or after the calibration for all of them
+static bool CheckBackgroundSlow(void) {
+  PixelToPosEstimator truth = CreateEstimator(0.0);
+  PixelToPosEstimator estimator = CreateEstimator(0.5);
+  PTPESetProgress(&estimator, Silent, NULL);
+  unsigned int seed = 1;
+  PTPEDataset* dataset = PTPEDatasetCreateSynthetic(&truth, 50, 0.0,
+    0.0, 100.0, &seed);
+  VecFloat3D POVmin = VecFloatCreateStatic3D();
+  VecFloat3D POVmax = VecFloatCreateStatic3D();
+  for (int i = 3; i--;)
+    VecSet(&POVmax, i, (i == 1 ? 15.0 : 10.0));
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = BgStall;
+  sigaction(SIGUSR1, &action, NULL);
+  size_t size = sizeof(float) * 2 * TEST_BG_NBSLOW;
+  float* pxX = malloc(sizeof(float) * TEST_BG_NBSLOW);
+  float* pxY = malloc(sizeof(float) * TEST_BG_NBSLOW);
+  for (long iPos = 0; iPos < TEST_BG_NBSLOW; ++iPos) {
+    pxX[iPos] = TEST_WIDTH * (float)(iPos % 256) / 256.0;
+    pxY[iPos] = TEST_HEIGHT * (float)(iPos / 256) / 256.0;
+  }
+  float* before = malloc(size);
+  float* after = malloc(size);
+  BgSlowQuery query;
+  query._estimator = &estimator;
+  query._pxX = pxX;
+  query._pxY = pxY;
+  query._before = before;
+  query._meter = malloc(size);
+  query._other = malloc(size);
+  bool isOk = true;
+  srandom(1);
+  for (int iCycle = 0; isOk && iCycle < TEST_BG_NBCYCLE; ++iCycle) {
+    // Results with the parameters before the calibration
+    PixelToPosEstimator expected = CreateEstimator(0.0);
+    PTPESetParam(&expected, estimator._param);
+    PTPEGetPxToMeterBatch(&expected, TEST_BG_NBSLOW, pxX, pxY, before,
+      before + TEST_BG_NBSLOW);
+    // Query the estimator during the calibration, the query in progress
+    // when the calibration starts is stalled
+    atomic_bool stop;
+    atomic_init(&stop, false);
+    query._stop = &stop;
+    atomic_init(&(query._nbQuery), 0);
+    query._hasOther = false;
+    query._isMixed = false;
+    pthread_t thread;
+    pthread_create(&thread, NULL, BgSlowQueryMain, &query);
+    while (atomic_load(&(query._nbQuery)) == 0)
+      sched_yield();
+    PTPEBackgroundStart(&estimator, dataset, 200, 0.0, &POVmin, &POVmax);
+    pthread_kill(thread, SIGUSR1);
+    PTPEStopReason stopReason = PTPEBackgroundJoin(&estimator);
+    atomic_store(&stop, true);
+    pthread_join(thread, NULL);
+    // Check the results against those with the parameters after the
+    // calibration
+    PTPESetParam(&expected, estimator._param);
+    PTPEGetPxToMeterBatch(&expected, TEST_BG_NBSLOW, pxX, pxY, after,
+      after + TEST_BG_NBSLOW);
+    isOk = (stopReason != PTPEStopReasonCancel) && !(query._isMixed) &&
+      (!(query._hasOther) || memcmp(query._other, after, size) == 0);
+    PixelToPosEstimatorFreeStatic(&expected);
+  }
+  free(pxX);
+  free(pxY);
+  free(before);
+  free(after);
+  free(query._meter);
+  free(query._other);
+  PTPEDatasetFree(&dataset);
+  PixelToPosEstimatorFreeStatic(&estimator);
+  PixelToPosEstimatorFreeStatic(&truth);
+  return isOk;
+}
+
+// Check that PTPEGetPxToMeterBatch gives the same real positions as
+// PTPEGetPxToMeter for screen positions viewing the ground
+static bool CheckPxToMeterBatch(void) {
+  PixelToPosEstimator estimator = CreateEstimator(0.0);
+  unsigned int seed = 1;
+  PTPEDataset* dataset = PTPEDatasetCreateSynthetic(&estimator,
+    TEST_CONV_NB, 0.0, 0.0, TEST_CONV_MAXDIST, &seed);
+  float* meterX = malloc(sizeof(float) * TEST_CONV_NB);
+  float* meterZ = malloc(sizeof(float) * TEST_CONV_NB);
+  PTPEGetPxToMeterBatch(&estimator, TEST_CONV_NB, dataset->_pxX,
+    dataset->_pxY, meterX, meterZ);
+  bool isOk = true;
+  VecFloat2D screenPos = VecFloatCreateStatic2D();
+  for (long iPos = 0; isOk && iPos < TEST_CONV_NB; ++iPos) {
+    VecSet(&screenPos, 0, dataset->_pxX[iPos]);
+    VecSet(&screenPos, 1, dataset->_pxY[iPos]);
+    VecFloat3D realPos = PTPEGetPxToMeter(&estimator, &screenPos);
+    float dist = VecDist(&realPos, &(estimator._cameraPos));
+    float err = hypot(meterX[iPos] - VecGet(&realPos, 0),
+      meterZ[iPos] - VecGet(&realPos, 2));
+    isOk = (err <= TEST_CONV_PRECMETER * dist);
+  }
+  free(meterX);
+  free(meterZ);
+  PTPEDatasetFree(&dataset);
+  PixelToPosEstimatorFreeStatic(&estimator);
+  return isOk;
+}
+
+// Check that PTPEGetMeterToPxBatch and PTPEGetMeterToPx give back the
+// screen positions of real positions on the ground converted by
+// PTPEGetPxToMeter, and reject the real positions behind the camera
+static bool CheckMeterToPx(void) {
+  PixelToPosEstimator estimator = CreateEstimator(0.0);
+  unsigned int seed = 1;
+  PTPEDataset* dataset = PTPEDatasetCreateSynthetic(&estimator,
+    TEST_CONV_NB, 0.0, 0.0, TEST_CONV_MAXDIST, &seed);
+  // Real positions in front of the camera followed by the same number
+  // of real positions behind it, opposite to the point of view and
+  // farther than the camera height (the nearer ones may still be in
+  // front of a camera looking down)
+  long nb = 2 * TEST_CONV_NB;
+  float* meterX = malloc(sizeof(float) * nb);
+  float* meterZ = malloc(sizeof(float) * nb);
+  float* pxX = malloc(sizeof(float) * nb);
+  float* pxY = malloc(sizeof(float) * nb);
+  bool* isValid = malloc(sizeof(bool) * nb);
+  // Horizontal direction from the camera to the point of view (cf
+  // PTPE_Px and PTPE_Pz)
+  float dirX = VecGet(estimator._param, 0) -
+    VecGet(&(estimator._cameraPos), 0);
+  float dirZ = VecGet(estimator._param, 2) -
+    VecGet(&(estimator._cameraPos), 2);
+  float norm = hypot(dirX, dirZ);
+  for (long iPos = 0; iPos < TEST_CONV_NB; ++iPos) {
+    meterX[iPos] = dataset->_meterX[iPos];
+    meterZ[iPos] = dataset->_meterZ[iPos];
+    float dist = TEST_CAMERAHEIGHT + (TEST_CONV_MAXDIST -
+      TEST_CAMERAHEIGHT) * (float)iPos / (float)TEST_CONV_NB;
+    meterX[TEST_CONV_NB + iPos] =
+      VecGet(&(estimator._cameraPos), 0) - dist * dirX / norm;
+    meterZ[TEST_CONV_NB + iPos] =
+      VecGet(&(estimator._cameraPos), 2) - dist * dirZ / norm;
+  }
+  PTPEGetMeterToPxBatch(&estimator, nb, meterX, meterZ, pxX, pxY,
+    isValid);
+  bool isOk = true;
+  VecFloat3D realPos = VecFloatCreateStatic3D();
+  VecFloat2D screenPos = VecFloatCreateStatic2D();
+  for (long iPos = 0; isOk && iPos < nb; ++iPos) {
+    VecSet(&realPos, 0, meterX[iPos]);
+    VecSet(&realPos, 2, meterZ[iPos]);
+    bool isFront = PTPEGetMeterToPx(&estimator, &realPos, &screenPos);
+    if (iPos < TEST_CONV_NB) {
+      isOk = isFront && isValid[iPos] &&
+        hypot(pxX[iPos] - VecGet(&screenPos, 0),
+          pxY[iPos] - VecGet(&screenPos, 1)) <= TEST_CONV_PRECPX &&
+        hypot(dataset->_pxX[iPos] - VecGet(&screenPos, 0),
+          dataset->_pxY[iPos] - VecGet(&screenPos, 1)) <=
+          TEST_CONV_PRECPX;
+    } else {
+      isOk = !isFront && !(isValid[iPos]) && isnan(pxX[iPos]) &&
+        isnan(pxY[iPos]) && isnan(VecGet(&screenPos, 0)) &&
+        isnan(VecGet(&screenPos, 1));
+    }
+  }
+  free(meterX);
+  free(meterZ);
+  free(pxX);
+  free(pxY);
+  free(isValid);
+  PTPEDatasetFree(&dataset);
+  PixelToPosEstimatorFreeStatic(&estimator);
+  return isOk;
+}
+
+// Check that PTPEInitHomographyDataset calculates the homography of
+// correspondences on the ground also when the origin of the screen is
+// on its horizon line, by comparing the real positions given by
+// PTPEGetPxToMeterHomography before and after moving the origin there
+static bool CheckHomography(void) {
+  PixelToPosEstimator estimator = CreateEstimator(0.0);
+  unsigned int seed = 1;
+  PTPEDataset* dataset = PTPEDatasetCreateSynthetic(&estimator,
+    TEST_CONV_NB, 0.0, 0.0, TEST_CONV_MAXDIST, &seed);
+  float* meterX = malloc(sizeof(float) * TEST_CONV_NB);
+  float* meterZ = malloc(sizeof(float) * TEST_CONV_NB);
+  VecFloat2D screenPos = VecFloatCreateStatic2D();
+  VecFloat3D realPos = VecFloatCreateStatic3D();
+  bool isOk = PTPEInitHomographyDataset(&estimator, dataset);
+  for (long iPos = 0; isOk && iPos < TEST_CONV_NB; ++iPos) {
+    VecSet(&screenPos, 0, dataset->_pxX[iPos]);
+    VecSet(&screenPos, 1, dataset->_pxY[iPos]);
+    isOk = PTPEGetPxToMeterHomography(&estimator, &screenPos, &realPos);
+    meterX[iPos] = VecGet(&realPos, 0);
+    meterZ[iPos] = VecGet(&realPos, 2);
+  }
+  // Move the origin of the screen to the point of the horizon line of
+  // the homography nearest to the center of the image
+  const float* h = estimator._homography;
+  float x = TEST_WIDTH * 0.5;
+  float y = TEST_HEIGHT * 0.5;
+  float d = (h[6] * x + h[7] * y + h[8]) / (h[6] * h[6] + h[7] * h[7]);
+  x -= d * h[6];
+  y -= d * h[7];
+  for (long iPos = 0; iPos < TEST_CONV_NB; ++iPos) {
+    dataset->_pxX[iPos] -= x;
+    dataset->_pxY[iPos] -= y;
+  }
+  isOk = isOk && PTPEInitHomographyDataset(&estimator, dataset);
+  for (long iPos = 0; isOk && iPos < TEST_CONV_NB; ++iPos) {
+    VecSet(&screenPos, 0, dataset->_pxX[iPos]);
+    VecSet(&screenPos, 1, dataset->_pxY[iPos]);
+    isOk = PTPEGetPxToMeterHomography(&estimator, &screenPos, &realPos);
+    float dist = VecDist(&realPos, &(estimator._cameraPos));
+    isOk = isOk && hypot(VecGet(&realPos, 0) - meterX[iPos],
+      VecGet(&realPos, 2) - meterZ[iPos]) <= TEST_HOM_PREC * dist;
+  }
+  free(meterX);
+  free(meterZ);
+  PTPEDatasetFree(&dataset);
+  PixelToPosEstimatorFreeStatic(&estimator);
+  return isOk;
+}
+
+// Check that the evaluation of degenerated parameters, the null vector
+// and a point of view at the camera position, is HUGE_VAL instead of
+// not a number, with and without cutoff
+static bool CheckEvaluateDegenerated(void) {
+  PixelToPosEstimator estimator = CreateEstimator(0.0);
+  unsigned int seed = 1;
+  PTPEDataset* dataset = PTPEDatasetCreateSynthetic(&estimator,
+    TEST_CONV_NB, 0.0, 0.0, TEST_CONV_MAXDIST, &seed);
+  VecFloat* param = VecFloatCreate(PTPE_NBPARAM);
+  bool isOk = true;
+  for (int iParam = 0; isOk && iParam < 2; ++iParam) {
+    if (iParam == 1) {
+      VecCopy(param, estimator._param);
+      for (int i = 3; i--;)
+        VecSet(param, i, VecGet(&(estimator._cameraPos), i));
+    }
+    float cutoff = PTPEEvaluateParamDataset(&estimator,
+      estimator._param, dataset);
+    bool isRejected = false;
+    isOk = (PTPEEvaluateParamDataset(&estimator, param, dataset) ==
+      HUGE_VAL) &&
+      (PTPEEvaluateParamDatasetBounded(&estimator, param, dataset,
+      cutoff, &isRejected) == HUGE_VAL);
+  }
+  VecFree(&param);
+  PTPEDatasetFree(&dataset);
+  PixelToPosEstimatorFreeStatic(&estimator);
+  return isOk;
+}
+
+// Checks and their names
+typedef struct Check {
+  const char* _name;
+  bool (*_fun)(void);
+} Check;
+static const Check checks[] = {
+  {"background", CheckBackground},
+  {"background slow query", CheckBackgroundSlow},
+  {"px to meter batch", CheckPxToMeterBatch},
+  {"meter to px", CheckMeterToPx},
+  {"homography", CheckHomography},
+  {"evaluate degenerated", CheckEvaluateDegenerated}
+};
+
+int main(void) {
+  int nbFailed = 0;
+  for (size_t iCheck = 0; iCheck < sizeof(checks) / sizeof(Check);
+    ++iCheck) {
+    bool isOk = checks[iCheck]._fun();
+    printf("%s: %s\n", checks[iCheck]._name, (isOk ? "OK" : "FAILED"));
+    if (!isOk)
+      ++nbFailed;
+  }
+  // Return success code if all the checks succeeded
+  return (nbFailed == 0 ? 0 : 1);
+}